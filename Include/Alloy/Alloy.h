@@ -16,6 +16,7 @@
 #include "../Source/Entity.h"
 #include "../Source/EntityManager.h"
 #include "../Source/Query.h"
+#include "../Source/Schedule.h"
 #include "../Source/Space.h"
 #include "../Source/SpaceQueryCoupler.h"
 #include "AlloyConfig.h"
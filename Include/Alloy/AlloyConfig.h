@@ -22,22 +22,45 @@
 // Just define: ALLOY_EXPOSE_INTERNALS
 // =========================
 
+// ==== Alloy Update Instrumentation ====
+// Just define: ALLOY_INSTRUMENTATION
+// =========================
+
+// ==== Alloy Structural Operation Latency Histograms ====
+// Just define: ALLOY_LATENCY_HISTOGRAMS
+// =========================
+
+// ==== Alloy Static Component List ====
+// Define as a header that defines X::StaticComponents, listing every component, see ComponentTypeTraits.h
+// Component IDs and sizes become constants, unlisted components fail to compile
+// Just define: ALLOY_STATIC_COMPONENTS "MyComponents.h"
+// =========================
+
+// The backends below may also be picked by defining one of their options before including Alloy (or on the command line)
+
 // ==== How to allocate components ====
-#define ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE
+#if !defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE) && !defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
+    #define ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE
 //#define ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE
+#endif
 // ====================================
 
 // ==== How to store runtimeArchetypesMap ====
-#define ALLOY_ARCHETYPES_TYPE_HEAT_VECTOR
+#if !defined(ALLOY_ARCHETYPES_TYPE_HEAT_VECTOR) && !defined(ALLOY_ARCHETYPES_TYPE_UNORDERED_MAP) && \
+    !defined(ALLOY_ARCHETYPES_TYPE_ORDERED_VECTOR) && !defined(ALLOY_ARCHETYPES_TYPE_UNORDERED_VECTOR)
+    #define ALLOY_ARCHETYPES_TYPE_HEAT_VECTOR
 // #define ALLOY_ARCHETYPES_TYPE_UNORDERED_MAP
 // #define ALLOY_ARCHETYPES_TYPE_ORDERED_VECTOR
 // #define ALLOY_ARCHETYPES_TYPE_UNORDERED_VECTOR
+#endif
 // =================================
 
 // ==== Type to use for entity sparse sets ====
-#define ALLOY_SPARSE_SET_TYPE_VECTOR
+#if !defined(ALLOY_SPARSE_SET_TYPE_VECTOR) && !defined(ALLOY_SPARSE_SET_TYPE_DEQUE)
+    #define ALLOY_SPARSE_SET_TYPE_VECTOR
 // vvv Is, generally, SIGNIFICANTLY slower
 //#define ALLOY_SPARSE_SET_TYPE_DEQUE
+#endif
 // ============================================
 
 #ifdef ALLOY_DEBUG
@@ -54,6 +77,16 @@
     #define ALLOY_ASSERT(condition, message)
 #endif // ALLOY_DEBUG
 
+// Hints that the given address will be read soon
+#if defined(__GNUC__) || defined(__clang__)
+    #define ALLOY_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <xmmintrin.h>
+    #define ALLOY_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+    #define ALLOY_PREFETCH(address) ((void) (address))
+#endif
+
 namespace X
 {
 
@@ -101,6 +134,13 @@ constexpr T ExponentBaseTwo(T exponent)
 // How runtimeArchetypesMap are stored in the chunk allocator
 inline const constexpr size_t ArchetypesPerChunkPower = 7; // 128
 inline const constexpr size_t ArchetypesPerChunk = ExponentBaseTwo(ArchetypesPerChunkPower);
+// Rows per column chunk with ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE
+inline const constexpr size_t PoolRowsPerChunkPower = 8; // 256
+inline const constexpr size_t PoolRowsPerChunk = ExponentBaseTwo(PoolRowsPerChunkPower);
+// How many entities ahead Space::Gather prefetches
+inline const constexpr size_t GatherPrefetchDistance = 8;
+// Below this many entity IDs the lookup tables are assumed cache resident and Space::Gather skips prefetching
+inline const constexpr size_t GatherPrefetchMinimumEntities = 1 << 16;
 
 } // namespace Internal
 // ==================
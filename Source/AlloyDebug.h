@@ -3,7 +3,7 @@
 #include "Entity.h"
 #include "Space.h"
 
-// TODO: Make this either a string return or a data structure??
+// Prefer Space::GetMemoryStats for anything but printing
 // NOTE: These WILL get optimized out if not called and won't be available to GDB/LLDB if not called at some point
 namespace X
 {
@@ -36,11 +36,28 @@ inline void GetSpaceInfo(X::Space& space, bool verbose)
         if (!foundMask)
             std::cout << tab << tab << tab << "DEFAULT MASK (NONE)" << std::endl;
 
-        X::Internal::Pool& pool = archetype->GetPool();
+        const X::ArchetypeMemoryStats stats = archetype->GetMemoryStats();
         std::cout << tab << tab << "POOL: " << std::endl;
-        std::cout << tab << tab << tab << "SIZE: " << pool.GetSize() << std::endl;
-        std::cout << tab << tab << tab << "CAPACITY: " << pool.GetCapacity() << std::endl;
+        std::cout << tab << tab << tab << "SIZE: " << stats.rows << std::endl;
+        std::cout << tab << tab << tab << "CAPACITY: " << stats.capacity << std::endl;
+        std::cout << tab << tab << tab << "BYTES USED: " << stats.usedBytes << std::endl;
+        std::cout << tab << tab << tab << "BYTES RESERVED: " << stats.reservedBytes << std::endl;
+        if (verbose)
+            for (const X::ColumnMemoryStats& column : stats.columns)
+                std::cout << tab << tab << tab << tab << X::Internal::ComponentTypeTraits::GetComponentInfo()[column.componentId].name
+                          << " : " << column.usedBytes << " / " << column.reservedBytes << std::endl;
+        std::cout << tab << tab << "ENTITY MAP BYTES: " << stats.entityMapBytes << std::endl;
+        std::cout << tab << tab << "EDGE BYTES: " << stats.edgeBytes << std::endl;
+        std::cout << tab << tab << "COLUMN TABLE BYTES: " << stats.columnTableBytes << std::endl;
     }
+
+    const X::EntityManagerMemoryStats entityManagerStats = space.GetMemoryStats().entityManager;
+    std::cout << tab << "ENTITY MANAGER BYTES:" << std::endl;
+    std::cout << tab << tab << "ARCHETYPE LOOKUP: " << entityManagerStats.archetypeLookupBytes << std::endl;
+    std::cout << tab << tab << "GENERATION LOOKUP: " << entityManagerStats.generationLookupBytes << std::endl;
+    std::cout << tab << tab << "RECYCLED IDS: " << entityManagerStats.recycledIdBytes << std::endl;
+    std::cout << tab << tab << "HIERARCHY: " << entityManagerStats.hierarchyBytes << std::endl;
+    std::cout << tab << tab << "SPARSE STORAGE: " << entityManagerStats.sparseStorageBytes << std::endl;
     std::cout << "=====" << std::endl;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <utility>
 
 #include "ComponentTypeTraits.h"
@@ -15,7 +16,9 @@ public:
     explicit Archetype() : pool(),
                            componentMask(Internal::ComponentTypeTraits::CurrentCount()),
                            forwardArchetypes(Internal::ComponentTypeTraits::CurrentCount()),
-                           backwardArchetypes(Internal::ComponentTypeTraits::CurrentCount())
+                           backwardArchetypes(Internal::ComponentTypeTraits::CurrentCount()),
+                           forwardMoves(Internal::ComponentTypeTraits::CurrentCount()),
+                           backwardMoves(Internal::ComponentTypeTraits::CurrentCount())
     {}
 
     ~Archetype() = default;
@@ -48,15 +51,16 @@ public:
         Internal::Pool::IndexType oldIndex = oldArchetype->entityMap[entity];
         Internal::Pool::IndexType nextIndex = pool.GetNextIndex(entity);
         // Copy existing components over
-        for (size_t i = 0; i < oldArchetype->componentMask.GetSize(); ++i)
-            if (oldArchetype->componentMask[i] == BitSet::True)
-                pool.CopyComponentToPool(nextIndex, i, oldArchetype->pool.GetComponentRaw(oldIndex, i));
+        MoveColumns(oldArchetype, oldArchetype->forwardMoves[Internal::GetComponentId<NewComponent>::value], oldIndex, nextIndex);
         // Register new entity link
         EntityMapAssureSizeAndSet(entity, nextIndex);
         // Add the new component
         NewComponent& newComponent = pool.EmplaceComponent<NewComponent>(nextIndex, Internal::GetComponentId<NewComponent>::value, std::forward<Args>(args)...);
         // Remove from old archetype
         oldArchetype->RemoveEntity<false>(entity);
+#ifdef ALLOY_INSTRUMENTATION
+        oldArchetype->RecordTransition(oldArchetype->forwardTransitions, Internal::GetComponentId<NewComponent>::value, oldArchetype->pool.GetArchetypeSize());
+#endif
         return newComponent;
     }
 
@@ -67,15 +71,16 @@ public:
         Internal::Pool::IndexType oldIndex = oldArchetype->entityMap[entity];
         Internal::Pool::IndexType nextIndex = pool.GetNextIndex(entity);
         // Copy existing components over
-        for (size_t i = 0; i < oldArchetype->componentMask.GetSize(); ++i)
-            if (oldArchetype->componentMask[i] == BitSet::True)
-                pool.CopyComponentToPool(nextIndex, i, oldArchetype->pool.GetComponentRaw(oldIndex, i));
+        MoveColumns(oldArchetype, oldArchetype->forwardMoves[Internal::GetComponentId<NewComponent>::value], oldIndex, nextIndex);
         // Register new entity link
         EntityMapAssureSizeAndSet(entity, nextIndex);
         // Add the new component
         pool.InsertComponent<NewComponent>(nextIndex, Internal::GetComponentId<NewComponent>::value, component);
         // Remove from old archetype
         oldArchetype->RemoveEntity<false>(entity);
+#ifdef ALLOY_INSTRUMENTATION
+        oldArchetype->RecordTransition(oldArchetype->forwardTransitions, Internal::GetComponentId<NewComponent>::value, oldArchetype->pool.GetArchetypeSize());
+#endif
     }
 
     // Transfer to this archetype while removing a component
@@ -85,21 +90,62 @@ public:
         Internal::Pool::IndexType oldIndex = oldArchetype->entityMap[entity];
         Internal::Pool::IndexType nextIndex = pool.GetNextIndex(entity);
         // Copy existing components over, minus one
-        for (size_t i = 0; i < componentMask.GetSize(); ++i)
+        MoveColumns(oldArchetype, oldArchetype->backwardMoves[Internal::GetComponentId<Component>::value], oldIndex, nextIndex);
+        // Register new entity link
+        EntityMapAssureSizeAndSet(entity, nextIndex);
+        // Remove from old archetype
+        // Don't destroy because the transfer above already did
+        oldArchetype->RemoveEntity<false>(entity);
+#ifdef ALLOY_INSTRUMENTATION
+        oldArchetype->RecordTransition(oldArchetype->backwardTransitions, Internal::GetComponentId<Component>::value, pool.GetArchetypeSize());
+#endif
+    }
+
+    // Transfer to this archetype while adding a shared component, which has no column to fill
+    void TransferEntityShared(Archetype* oldArchetype, const Entity entity)
+    {
+        SharedEdge* sharedEdge = nullptr;
+        for (SharedEdge& edge : oldArchetype->sharedForwardArchetypes)
         {
-            if (componentMask[i] == BitSet::True)
-                pool.CopyComponentToPool(nextIndex, i, oldArchetype->pool.GetComponentRaw(oldIndex, i));
+            if (edge.archetype == this)
+            {
+                sharedEdge = &edge;
+                break;
+            }
         }
+        ALLOY_ASSERT(sharedEdge != nullptr, "Shared component edge was not linked.");
+
+        Internal::Pool::IndexType oldIndex = oldArchetype->entityMap[entity];
+        Internal::Pool::IndexType nextIndex = pool.GetNextIndex(entity);
+        // Copy existing components over
+        MoveColumns(oldArchetype, sharedEdge->columnMoves, oldIndex, nextIndex);
         // Register new entity link
         EntityMapAssureSizeAndSet(entity, nextIndex);
         // Remove from old archetype
-        // Don't destroy because the transfer above already did
         oldArchetype->RemoveEntity<false>(entity);
+#ifdef ALLOY_INSTRUMENTATION
+        ++sharedEdge->moves;
+        sharedEdge->bytes += pool.GetArchetypeSize();
+#endif
+    }
+
+    [[nodiscard]] ArchetypeMemoryStats GetMemoryStats() const
+    {
+        ArchetypeMemoryStats stats{};
+        pool.GetMemoryStats(stats);
+        stats.entityMapBytes = Internal::GetReservedBytes(entityMap);
+        stats.edgeBytes = Internal::GetReservedBytes(forwardArchetypes) +
+                          Internal::GetReservedBytes(backwardArchetypes) +
+                          Internal::GetReservedBytes(sharedForwardArchetypes) +
+                          Internal::GetReservedBytes(forwardMoves) +
+                          Internal::GetReservedBytes(backwardMoves) +
+                          Internal::GetReservedBytes(edgeMoves);
+        return stats;
     }
 
     // Entity -> Pool -> Component
     template<typename Component>
-    [[nodiscard]] Component& GetComponent(const Entity entity)
+    [[nodiscard]] Internal::ComponentReference<Component> GetComponent(const Entity entity)
     {
         ALLOY_ASSERT(entityMap[entity] != InvalidIndex, "Archetype does not hold the given entity.");
         return pool.GetComponent<Component>(entityMap[entity]);
@@ -114,6 +160,64 @@ public:
         return function(pool.GetComponent<Components>(entityIndex)...);
     }
 
+    // Stable sort of every row by a given component
+    // Already sorted pools cost a single comparison pass, nearly sorted pools are fixed with an insertion sort
+    // Returns whether any row moved
+    template<typename Component, typename Comparator>
+    bool Sort(Comparator&& comparator, std::vector<Internal::Pool::IndexType>& order)
+    {
+        const size_t size = pool.GetSize();
+        auto compareRows = [this, &comparator](const Internal::Pool::IndexType lhs, const Internal::Pool::IndexType rhs) {
+            return comparator(
+                static_cast<const Component&>(pool.GetComponent<Component>(lhs)),
+                static_cast<const Component&>(pool.GetComponent<Component>(rhs)));
+        };
+
+        // Find the first out of order row
+        Internal::Pool::IndexType first = 1;
+        while (first < size && !compareRows(first, first - 1))
+            ++first;
+        if (first >= size)
+            return false;
+
+        order.resize(size);
+        for (Internal::Pool::IndexType i = 0; i < size; ++i)
+            order[i] = i;
+
+        // Insertion sort is linear in the number of displaced rows, give up on it if too many rows moved
+        size_t shiftBudget = size * 4;
+        bool withinBudget = true;
+        for (Internal::Pool::IndexType i = first; i < size && withinBudget; ++i)
+        {
+            Internal::Pool::IndexType row = order[i];
+            Internal::Pool::IndexType j = i;
+            for (; j > 0 && compareRows(row, order[j - 1]); --j)
+            {
+                order[j] = order[j - 1];
+                if (--shiftBudget == 0)
+                {
+                    withinBudget = false;
+                    break;
+                }
+            }
+            order[j] = row;
+        }
+
+        if (!withinBudget)
+        {
+            for (Internal::Pool::IndexType i = 0; i < size; ++i)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), compareRows);
+        }
+
+        pool.Permute(order);
+
+        // Fix the entity -> row links
+        for (Internal::Pool::IndexType i = 0; i < size; ++i)
+            entityMap[pool.GetParent(i)] = i;
+        return true;
+    }
+
     template<bool Destroy = true>
     void RemoveEntity(const Entity entity)
     {
@@ -121,6 +225,28 @@ public:
         Archetype::RemoveEntityInternal<Destroy>(entity);
     }
 
+    // Destroys every entity's components at once, the pool keeps its capacity
+    // The entities themselves are invalidated by the entity manager
+    void Clear()
+    {
+#ifdef ALLOY_DEBUG
+        for (Internal::Pool::IndexType i = 0; i < pool.GetSize(); ++i)
+            entityMap[pool.GetParent(i)] = InvalidIndex;
+#endif
+        pool.Clear();
+    }
+
+    [[nodiscard]] Internal::Pool::IndexType GetIndex(const Entity entity) const
+    {
+        ALLOY_ASSERT(entityMap[entity] != InvalidIndex, "Archetype does not hold the given entity.");
+        return entityMap[entity];
+    }
+
+    void PrefetchIndex(const Entity entity) const
+    {
+        ALLOY_PREFETCH(&entityMap[entity]);
+    }
+
     [[nodiscard]] BitSet& GetComponentMask()
     {
         return componentMask;
@@ -141,7 +267,84 @@ public:
         return backwardArchetypes;
     }
 
+    // Range of edgeMoves, the columns an entity moving along an edge copies
+    struct MoveRange
+    {
+        uint32_t first{ 0 };
+        uint32_t count{ 0 };
+    };
+
+    // Points a forward or backward edge at the next archetype, mapping the columns both archetypes hold once
+    template<bool Forward>
+    void LinkEdge(const Internal::ComponentTypeTraits::ComponentId componentId, Archetype* nextArchetype)
+    {
+        if constexpr (Forward)
+        {
+            forwardArchetypes[componentId] = nextArchetype;
+            forwardMoves[componentId] = MapColumns(nextArchetype);
+        }
+        else
+        {
+            backwardArchetypes[componentId] = nextArchetype;
+            backwardMoves[componentId] = MapColumns(nextArchetype);
+        }
+    }
+
+    struct SharedEdge
+    {
+        Internal::ComponentTypeTraits::ComponentId componentId;
+        // Mask value of the shared component in the next archetype
+        ::Internal::BitSetValue maskValue;
+        Archetype* archetype;
+        MoveRange columnMoves;
+#ifdef ALLOY_INSTRUMENTATION
+        size_t moves{ 0 };
+        size_t bytes{ 0 };
+#endif
+    };
+
+    // Adding a shared component leads to a different archetype per value
+    [[nodiscard]] std::vector<SharedEdge>& GetSharedForwardArchetypes()
+    {
+        return sharedForwardArchetypes;
+    }
+
+    void LinkSharedEdge(const Internal::ComponentTypeTraits::ComponentId componentId, const ::Internal::BitSetValue maskValue, Archetype* nextArchetype)
+    {
+        sharedForwardArchetypes.emplace_back(SharedEdge{ componentId, maskValue, nextArchetype, MapColumns(nextArchetype) });
+    }
+
+#ifdef ALLOY_INSTRUMENTATION
+    // Entities moved, and row bytes copied, along a graph edge
+    struct EdgeTransitions
+    {
+        size_t moves{ 0 };
+        size_t bytes{ 0 };
+    };
+
+    // Component ID -> Transitions along the matching forward edge, empty until an entity moves
+    [[nodiscard]] const std::vector<EdgeTransitions>& GetForwardTransitions() const
+    {
+        return forwardTransitions;
+    }
+
+    [[nodiscard]] const std::vector<EdgeTransitions>& GetBackwardTransitions() const
+    {
+        return backwardTransitions;
+    }
+#endif
+
 protected:
+#ifdef ALLOY_INSTRUMENTATION
+    static void RecordTransition(std::vector<EdgeTransitions>& transitions, const Internal::ComponentTypeTraits::ComponentId componentId, const size_t bytes)
+    {
+        if (componentId >= transitions.size())
+            transitions.resize(componentId + 1);
+        ++transitions[componentId].moves;
+        transitions[componentId].bytes += bytes;
+    }
+#endif
+
     static constexpr Internal::Pool::IndexType InvalidIndex = std::numeric_limits<X::Internal::Pool::IndexType>::max();
 
     template<bool Destroy>
@@ -152,11 +355,9 @@ protected:
 
         if constexpr (Destroy)
         {
-            auto& componentIds = pool.GetComponentIds();
-            for (X::Internal::ComponentTypeTraits::ComponentId componentId : componentIds)
+            for (const Internal::Pool::Column& column : pool.GetColumns())
             {
-                uint8_t* c = pool.Get(componentId, poolIndex);
-                Internal::ComponentTypeTraits::GetComponentInfo()[componentId].destructorCaller(c);
+                column.destructorCaller(pool.Get(column.componentId, poolIndex));
                 poolIndex = entityMap[entity];
             }
         }
@@ -183,6 +384,23 @@ protected:
 #endif
     }
 
+    // Appends the column moves from this archetype to the next one, the entity column is written by GetNextIndex
+    [[nodiscard]] MoveRange MapColumns(const Archetype* nextArchetype)
+    {
+        const size_t first = edgeMoves.size();
+        Internal::Pool::MapColumns(pool, nextArchetype->pool, edgeMoves);
+        return MoveRange{ static_cast<uint32_t>(first), static_cast<uint32_t>(edgeMoves.size() - first) };
+    }
+
+    // Copies a row of another archetype in along one of its edges
+    void MoveColumns(const Archetype* oldArchetype,
+                     const MoveRange moves,
+                     const Internal::Pool::IndexType oldIndex,
+                     const Internal::Pool::IndexType nextIndex)
+    {
+        pool.MoveRow(oldArchetype->pool, oldArchetype->edgeMoves.data() + moves.first, moves.count, oldIndex, nextIndex);
+    }
+
     void EntityMapAssureSizeAndSet(IdType entity, Internal::Pool::IndexType index)
     {
         if (entityMap.size() <= entity)
@@ -229,6 +447,16 @@ protected:
     // Graph of how to find the next archetype
     std::vector<Archetype*> forwardArchetypes;
     std::vector<Archetype*> backwardArchetypes;
+    std::vector<SharedEdge> sharedForwardArchetypes{};
+    // Component ID -> Column moves along the matching edge, filled when the edge is linked
+    std::vector<MoveRange> forwardMoves;
+    std::vector<MoveRange> backwardMoves;
+    // Column moves of every linked edge
+    std::vector<Internal::Pool::ColumnMove> edgeMoves{};
+#ifdef ALLOY_INSTRUMENTATION
+    std::vector<EdgeTransitions> forwardTransitions{};
+    std::vector<EdgeTransitions> backwardTransitions{};
+#endif
 
     // This archetype's components
     Internal::Pool pool;
@@ -237,6 +465,7 @@ protected:
     SparseSetContainer<X::Internal::Pool::IndexType> entityMap{ 0 };
 
     // Stores components the archetype holds
+    // Shared components store their value's ID (offset by BitSet::True) so values take part in the archetype's identity
     BitSet componentMask;
 };
 
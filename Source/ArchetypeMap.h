@@ -7,7 +7,9 @@
 #include "Archetype.h"
 #include "Containers/HeatVector.h"
 #include "Entity.h"
+#include "LatencyHistogram.h"
 #include "QueryInterface.h"
+#include "SharedValueStorage.h"
 #include "Utilities.h"
 
 namespace X
@@ -31,7 +33,7 @@ struct BitSetPairHash
     }
 };
 
-bool CompareBitSet(const BitSet& a, const BitSet& b)
+inline bool CompareBitSet(const BitSet& a, const BitSet& b)
 {
     return BitSet::BitSetHash()(a) > BitSet::BitSetHash()(b);
 }
@@ -95,30 +97,33 @@ using ArchetypesMapType = HeatVector<BitSetPair<Archetype*>>;
 
 class ArchetypeMap
 {
-    // Needs to be here to deduce auto :(
 private:
-    [[nodiscard]] auto FindArchetype(const BitSet& componentMask)
+    // Returns the registered archetype with the given mask, or nullptr
+    [[nodiscard]] Archetype* FindArchetype(const BitSet& componentMask)
     {
 #ifdef ALLOY_ARCHETYPES_TYPE_UNORDERED_MAP
-        return ArchetypesMapType.find(componentMask);
+        auto foundArchetype = archetypesMap.find(componentMask);
+        return foundArchetype != archetypesMap.end() ? foundArchetype->second : nullptr;
 #elif defined(ALLOY_ARCHETYPES_TYPE_ORDERED_VECTOR)
-        auto val = std::lower_bound(
-            ArchetypesMapType.begin(), ArchetypesMapType.end(), componentMask, ArchetypeMapsCompareBitSetAndPair() //
+        auto foundArchetype = std::lower_bound(
+            archetypesMap.begin(), archetypesMap.end(), componentMask, ArchetypeMapsCompareBitSetAndPair() //
         );
-        if (BitSet::BitSetHash()(val->first) == BitSet::BitSetHash()(componentMask))
-            return val;
-        return ArchetypesMapType.end();
+        if (foundArchetype != archetypesMap.end() && BitSet::BitSetHash()(foundArchetype->first) == BitSet::BitSetHash()(componentMask))
+            return foundArchetype->second;
+        return nullptr;
 #elif defined(ALLOY_ARCHETYPES_TYPE_UNORDERED_VECTOR)
-        return std::find_if(
-            ArchetypesMapType.begin(),
-            ArchetypesMapType.end(),
+        auto foundArchetype = std::find_if(
+            archetypesMap.begin(),
+            archetypesMap.end(),
             [&componentMask](const BitSetPair<Archetype*>& item) {
                 return BitSet::BitSetHash()(item.first) == BitSet::BitSetHash()(componentMask);
             });
+        return foundArchetype != archetypesMap.end() ? foundArchetype->second : nullptr;
 #elif defined(ALLOY_ARCHETYPES_TYPE_HEAT_VECTOR)
-        return archetypesMap.Find([=](const auto& item) {
+        auto foundArchetype = archetypesMap.Find([=](const auto& item) {
             return (BitSet::BitSetHash()(item.first) == BitSet::BitSetHash()(componentMask));
         });
+        return foundArchetype != archetypesMap.End() ? foundArchetype->second : nullptr;
 #endif
     }
 
@@ -129,15 +134,16 @@ public:
           parentSpaceId(parentSpace),
           baseArchetype(new Archetype())
     {
+        for (QueryInterface* query : QueryInterface::GetQueries())
+            query->AssureSpaceSize(parentSpaceId);
         RegisterRuntimeArchetype(baseArchetype);
     }
 
-    // Deletes all existing ArchetypesMapType and queries
+    // Deletes all registered archetypes, whichever map type holds them
     ~ArchetypeMap()
     {
-        archetypesMap.Each([](auto& pair) {
-            delete pair.second;
-        });
+        for (Archetype* archetype : archetypes)
+            delete archetype;
     }
 
     template<typename AddedComponent>
@@ -152,9 +158,65 @@ public:
         return GetArchetypeHelper<RemovedComponent, false>(currentArchetype);
     }
 
+    // Returns the archetype holding the current archetype's components plus a shared component with a given value
+    template<typename Component>
+    [[nodiscard]] Archetype* GetSharedForwardArchetype(Archetype* currentArchetype, Component&& value)
+    {
+        const ComponentTypeTraits::ComponentId componentId = GetComponentId<Component>::value;
+        const ::Internal::BitSetValue maskValue = BitSet::True + sharedValues.Get<Component>().Intern(std::move(value));
+
+        // 1) Check the cached edges for this value
+        std::vector<Archetype::SharedEdge>& sharedEdges = currentArchetype->GetSharedForwardArchetypes();
+        for (const Archetype::SharedEdge& sharedEdge : sharedEdges)
+        {
+            if (sharedEdge.componentId == componentId && sharedEdge.maskValue == maskValue)
+            {
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+                lastPath = ArchetypePath::EdgeHit;
+#endif
+                return sharedEdge.archetype;
+            }
+        }
+
+        // 2) Try to search ALL registered archetypes before creating a new one
+        lookupMask = currentArchetype->GetComponentMask();
+        lookupMask.Set(componentId, maskValue);
+        Archetype* nextArchetype = FindArchetype(lookupMask);
+        if (nextArchetype != nullptr)
+        {
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+            lastPath = ArchetypePath::MapHit;
+#endif
+        }
+        else
+        {
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+            lastPath = ArchetypePath::NewArchetype;
+            ScopedLatency creationLatency(StructuralOperation::ArchetypeCreation);
+#endif
+            // 3) Create a new archetype, holding the value in its mask
+            nextArchetype = Archetype::AddComponentToArchetype<Component>(currentArchetype);
+            nextArchetype->GetComponentMask().Set(componentId, maskValue);
+            RegisterRuntimeArchetype(nextArchetype);
+        }
+
+        currentArchetype->LinkSharedEdge(componentId, maskValue, nextArchetype);
+        return nextArchetype;
+    }
+
+    // Only the archetypes holding the query's rarest component are tested
     void RegisterQuery(QueryInterface* query)
     {
-        for (Archetype* archetype : archetypes)
+        const std::vector<Archetype*>* candidates = &archetypes;
+        for (size_t componentId : query->GetComponentIds())
+        {
+            if (componentId >= componentArchetypes.size())
+                return;
+            if (componentArchetypes[componentId].size() < candidates->size())
+                candidates = &componentArchetypes[componentId];
+        }
+
+        for (Archetype* archetype : *candidates)
             if (query->DoesBitSetMatch(archetype->GetComponentMask()))
                 query->RegisterArchetype(parentSpacePtr, parentSpaceId, archetype);
     }
@@ -166,12 +228,14 @@ public:
 
     void RegisterRuntimeArchetype(Archetype* archetype)
     {
+        AssignSharedValues(archetype);
+
 #ifdef ALLOY_ARCHETYPES_TYPE_UNORDERED_MAP
-        ArchetypesMapType.insert({ bitMask, archetype });
+        archetypesMap.insert({ archetype->GetComponentMask(), archetype });
 #elif defined(ALLOY_ARCHETYPES_TYPE_ORDERED_VECTOR)
-        InsertSortedPair(ArchetypesMapType, { bitMask, archetype });
+        InsertSortedPair(archetypesMap, { archetype->GetComponentMask(), archetype });
 #elif defined(ALLOY_ARCHETYPES_TYPE_UNORDERED_VECTOR)
-        ArchetypesMapType.emplace_back(std::make_pair(bitMask, archetype));
+        archetypesMap.emplace_back(std::make_pair(archetype->GetComponentMask(), archetype));
 #elif defined(ALLOY_ARCHETYPES_TYPE_HEAT_VECTOR)
         archetypesMap.EmplaceBack(std::make_pair(archetype->GetComponentMask(), archetype));
 #endif
@@ -179,6 +243,21 @@ public:
         RegisterArchetypeHelper(archetype);
     }
 
+    // Clears every archetype of the space, the archetypes and their edges are kept
+    void ClearArchetypes()
+    {
+        for (Archetype* archetype : archetypes)
+            archetype->Clear();
+    }
+
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+    // How the last forward or backward archetype was found
+    [[nodiscard]] ArchetypePath* GetLastPath()
+    {
+        return &lastPath;
+    }
+#endif
+
 #ifdef ALLOY_EXPOSE_INTERNALS
     [[nodiscard]] const std::vector<Archetype*>& GetArchetypes() const
     {
@@ -192,58 +271,96 @@ private:
     {
         // Getting the forward archetype is a 3 step process
 
-        Archetype** nextArchetype;
+        Archetype* nextArchetype;
         if constexpr (AddComponent)
-            nextArchetype = &currentArchetype->GetForwardArchetypes()[GetComponentId<Component>::value];
+            nextArchetype = currentArchetype->GetForwardArchetypes()[GetComponentId<Component>::value];
         else
-            nextArchetype = &currentArchetype->GetBackwardArchetypes()[GetComponentId<Component>::value];
+            nextArchetype = currentArchetype->GetBackwardArchetypes()[GetComponentId<Component>::value];
 
         // 1) Check if the next archetype is already assigned before searching ALL registered archetypes
-        if (*nextArchetype != nullptr)
-            return *nextArchetype;
+        if (nextArchetype != nullptr)
+        {
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+            lastPath = ArchetypePath::EdgeHit;
+#endif
+            return nextArchetype;
+        }
 
         // 2) Try to search ALL registered archetypes before creating a new one
-        BitSet componentMask = currentArchetype->GetComponentMask();
+        lookupMask = currentArchetype->GetComponentMask();
         if constexpr (AddComponent)
-            componentMask.Set(GetComponentId<Component>::value, BitSet::True);
+            lookupMask.Set(GetComponentId<Component>::value, BitSet::True);
         else
-            componentMask.Set(GetComponentId<Component>::value, BitSet::False);
+            lookupMask.Set(GetComponentId<Component>::value, BitSet::False);
 
-        auto foundArchetype = FindArchetype(componentMask);
+        Archetype* foundArchetype = FindArchetype(lookupMask);
 
         // Found a suitable archetype
-        if (foundArchetype != archetypesMap.End())
+        if (foundArchetype != nullptr)
         {
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+            lastPath = ArchetypePath::MapHit;
+#endif
             // Save it for faster lookup next time
-            *nextArchetype = foundArchetype->second;
-            return foundArchetype->second;
+            currentArchetype->LinkEdge<AddComponent>(GetComponentId<Component>::value, foundArchetype);
+            return foundArchetype;
         }
 
         // 3) Create a new archetype, after trying to look for an existing one
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+        lastPath = ArchetypePath::NewArchetype;
+        ScopedLatency creationLatency(StructuralOperation::ArchetypeCreation);
+#endif
         if constexpr (AddComponent)
-            *nextArchetype = Archetype::AddComponentToArchetype<Component>(currentArchetype);
+            nextArchetype = Archetype::AddComponentToArchetype<Component>(currentArchetype);
         else
-            *nextArchetype = Archetype::RemoveComponentFromArchetype<Component>(currentArchetype);
-        RegisterRuntimeArchetype(*nextArchetype);
-        return *nextArchetype;
+            nextArchetype = Archetype::RemoveComponentFromArchetype<Component>(currentArchetype);
+        currentArchetype->LinkEdge<AddComponent>(GetComponentId<Component>::value, nextArchetype);
+        RegisterRuntimeArchetype(nextArchetype);
+        return nextArchetype;
+    }
+
+    // Points the archetype's pool at the shared values its mask refers to
+    void AssignSharedValues(Archetype* archetype)
+    {
+        const BitSet& componentMask = archetype->GetComponentMask();
+        for (ComponentTypeTraits::ComponentId componentId : sharedValues.GetComponentIds())
+            if (componentMask[componentId] != BitSet::False)
+                archetype->GetPool().SetSharedValue(componentId, sharedValues.Get(componentId).GetRaw(componentMask[componentId] - BitSet::True));
     }
 
     void RegisterArchetypeHelper(Archetype* archetype)
     {
+        const BitSet& componentMask = archetype->GetComponentMask();
         archetypes.emplace_back(archetype);
-        for (QueryInterface* query : QueryInterface::GetQueries())
+        for (size_t componentId = 0; componentId < componentMask.GetRawData().size(); ++componentId)
         {
-            query->AssureSpaceSize(parentSpaceId);
-            if (query->DoesBitSetMatch(archetype->GetComponentMask()))
-                query->RegisterArchetype(parentSpacePtr, parentSpaceId, archetype);
+            if (componentMask[componentId] == BitSet::False)
+                continue;
+            if (componentId >= componentArchetypes.size())
+                componentArchetypes.resize(componentId + 1);
+            componentArchetypes[componentId].emplace_back(archetype);
         }
+
+        QueryInterface::EachCandidateQuery(componentMask, [this, archetype, &componentMask](QueryInterface* query) {
+            if (query->DoesBitSetMatch(componentMask))
+                query->RegisterArchetype(parentSpacePtr, parentSpaceId, archetype);
+        });
     }
 
     size_t parentSpaceId;
     Space* parentSpacePtr;
     std::vector<Archetype*> archetypes;
+    // Component ID -> Archetypes holding it
+    std::vector<std::vector<Archetype*>> componentArchetypes{};
     Archetype* baseArchetype;
     ArchetypesMapType archetypesMap{};
+    // Reused by archetype lookups, so only growing the component count allocates
+    BitSet lookupMask{ 0 };
+    SharedValueStorage sharedValues{};
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+    ArchetypePath lastPath{ ArchetypePath::None };
+#endif
 };
 
 } // namespace X::Internal
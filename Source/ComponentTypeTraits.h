@@ -1,10 +1,120 @@
 #pragma once
 
+#include <array>
+#include <memory>
+#include <type_traits>
+
 #include "Alloy/AlloyConfig.h"
+#include "Entity.h"
+
+namespace X
+{
+
+enum class StorageType
+{
+    // Stored in archetype pools, fastest to iterate
+    Table,
+    // Stored in a per-space sparse set outside of archetypes, fastest to add and remove
+    Sparse,
+    // One value per archetype, the value is part of the archetype's identity
+    // Values must be equality comparable and are read-only once added
+    Shared
+};
+
+// Specialize to change how a component is stored
+// template<>
+// struct X::ComponentStorageType<Stunned>
+// {
+//     static constexpr X::StorageType value = X::StorageType::Sparse;
+// };
+template<typename Component>
+struct ComponentStorageType
+{
+    static constexpr StorageType value = StorageType::Table;
+};
+
+template<typename... Components>
+struct ComponentList
+{};
+
+// With ALLOY_STATIC_COMPONENTS, define in that header every component a space may hold (including sparse, shared and tags)
+// struct X::StaticComponents
+// {
+//     using Type = X::ComponentList<Position, Velocity, Stunned>;
+// };
+struct StaticComponents;
+
+} // namespace X
+
+#ifdef ALLOY_STATIC_COMPONENTS
+    #include ALLOY_STATIC_COMPONENTS
+#endif
 
 namespace X::Internal
 {
 
+// Sparse components are not part of archetype masks
+template<typename Component>
+inline constexpr bool IsSparseComponent = ComponentStorageType<Component>::value == StorageType::Sparse;
+
+template<typename Component>
+inline constexpr bool IsSharedComponent = ComponentStorageType<Component>::value == StorageType::Shared;
+
+// Tags are empty components, they only take part in archetype masks and never get a pool column
+template<typename Component>
+inline constexpr bool IsTagComponent = ComponentStorageType<Component>::value == StorageType::Table &&
+                                       std::is_empty_v<Component> &&
+                                       std::is_trivially_destructible_v<Component> &&
+                                       std::is_default_constructible_v<Component>;
+
+// Components stored in a pool column
+template<typename Component>
+inline constexpr bool IsColumnComponent = ComponentStorageType<Component>::value == StorageType::Table && !IsTagComponent<Component>;
+
+// Shared components are handed out read-only, changing them would change the archetype's identity
+template<typename Component>
+using ComponentReference = std::conditional_t<IsSharedComponent<Component>, const Component&, Component&>;
+
+// Tags have no storage, every entity holding a tag shares this instance
+template<typename Component>
+[[nodiscard]] Component& GetTagInstance()
+{
+    static Component instance{};
+    return instance;
+}
+
+// Bytes of a component's pool column per row
+template<typename Component>
+inline constexpr size_t ComponentSize = IsColumnComponent<Component> ? sizeof(Component) : 0;
+
+#ifdef ALLOY_STATIC_COMPONENTS
+
+// The entity is always component 0, the listed components follow in order
+template<typename... Components>
+ComponentList<Entity, Components...> PrependEntity(ComponentList<Components...>);
+
+using StaticComponentList = decltype(PrependEntity(typename StaticComponents::Type{}));
+
+template<typename Component, typename... Components>
+constexpr size_t IndexOfComponent(ComponentList<Components...>)
+{
+    constexpr std::array<bool, sizeof...(Components)> matches{ std::is_same_v<Component, Components>... };
+    for (size_t i = 0; i < matches.size(); ++i)
+        if (matches[i])
+            return i;
+    return matches.size();
+}
+
+template<typename... Components>
+constexpr std::array<size_t, sizeof...(Components)> MakeComponentSizes(ComponentList<Components...>)
+{
+    return { ComponentSize<Components>... };
+}
+
+inline constexpr std::array StaticComponentSizes = MakeComponentSizes(StaticComponentList{});
+
+#endif // ALLOY_STATIC_COMPONENTS
+
 struct ComponentTypeTraits
 {
     using DestructorCaller = void (*)(uint8_t* object);
@@ -14,13 +124,37 @@ struct ComponentTypeTraits
     struct ComponentInfo
     {
         DestructorCaller destructorCaller;
+        // Trivially destructible rows can be dropped without a destructor pass
+        bool trivialDestructor;
         TransferCaller transferCaller;
+        // Zero for components without a pool column
         size_t size;
 #ifdef ALLOY_EXPOSE_INTERNALS
         std::string name;
 #endif
     };
 
+#ifdef ALLOY_STATIC_COMPONENTS
+
+    static constexpr ComponentId CurrentCount()
+    {
+        return StaticComponentSizes.size();
+    }
+
+    // Built on first use from the static component list, independent of static initialization order
+    static std::vector<ComponentInfo>& GetComponentInfo()
+    {
+        static std::vector<ComponentInfo> componentInfo = MakeStaticComponentInfo(StaticComponentList{});
+        return componentInfo;
+    }
+
+    [[nodiscard]] static constexpr size_t GetComponentSize(const ComponentId componentId)
+    {
+        return StaticComponentSizes[componentId];
+    }
+
+#else // Not ALLOY_STATIC_COMPONENTS
+
     // To get the final count, this must ONLY be called during run time
     static ComponentId& CurrentCount()
     {
@@ -34,13 +168,27 @@ struct ComponentTypeTraits
         return componentInfo;
     }
 
+    [[nodiscard]] static size_t GetComponentSize(const ComponentId componentId)
+    {
+        return GetComponentInfo()[componentId].size;
+    }
+
     template<typename Component>
     static ComponentId RegisterComponent()
+    {
+        GetComponentInfo().emplace_back(MakeComponentInfo<Component>());
+        return CurrentCount()++;
+    }
+
+#endif // ALLOY_STATIC_COMPONENTS
+
+    template<typename Component>
+    static ComponentInfo MakeComponentInfo()
     {
 #ifdef ALLOY_EXPOSE_INTERNALS
         std::string componentName = typeid(Component).name();
 #endif
-        size_t componentSize = sizeof(Component);
+        size_t componentSize = ComponentSize<Component>;
         DestructorCaller componentDestructorCaller;
         TransferCaller componentTransferCaller;
 
@@ -94,20 +242,40 @@ struct ComponentTypeTraits
             };
         }
 
-        GetComponentInfo().emplace_back(ComponentInfo{
+        return ComponentInfo{
             componentDestructorCaller,
+            std::is_trivially_destructible_v<Component>,
             componentTransferCaller,
             componentSize
 #ifdef ALLOY_EXPOSE_INTERNALS
             ,
             componentName //
 #endif
-        });
+        };
+    }
 
-        return CurrentCount()++;
+#ifdef ALLOY_STATIC_COMPONENTS
+
+    template<typename... Components>
+    static std::vector<ComponentInfo> MakeStaticComponentInfo(ComponentList<Components...>)
+    {
+        return { MakeComponentInfo<Components>()... };
     }
+
+#endif
 };
 
+#ifdef ALLOY_STATIC_COMPONENTS
+
+template<typename Component>
+struct GetComponentId
+{
+    static constexpr ComponentTypeTraits::ComponentId value = IndexOfComponent<Component>(StaticComponentList{});
+    static_assert(value < ComponentTypeTraits::CurrentCount(), "Component is not listed in X::StaticComponents.");
+};
+
+#else // Not ALLOY_STATIC_COMPONENTS
+
 template<typename Component>
 struct GetComponentId
 {
@@ -117,4 +285,6 @@ struct GetComponentId
 template<typename Component>
 const ComponentTypeTraits::ComponentId GetComponentId<Component>::value = ComponentTypeTraits::RegisterComponent<Component>();
 
+#endif // ALLOY_STATIC_COMPONENTS
+
 } // namespace X::Internal
@@ -17,7 +17,7 @@ public:
     {}
 
     template<typename Component>
-    [[nodiscard]] Component& GetComponent() const
+    [[nodiscard]] Internal::ComponentReference<Component> GetComponent() const
     {
         return space->GetComponentTemporary<Component>(entity);
     }
@@ -51,6 +51,7 @@ public:
     void SetEntity(X::Entity newEntity)
     {
         entity = newEntity;
+        cachedVersion = 0;
     }
 
     void DestroyEntity()
@@ -61,34 +62,53 @@ public:
 protected:
     X::Space* space{ nullptr };
     X::Entity entity{};
+    // Space structural version a derived wrapper's cache was filled at
+    // Space versions start at one, so zero is never current
+    mutable uint64_t cachedVersion{ 0 };
 };
 
+// Caches the component's address, which stays valid until the space's structural version changes
+// Repeat access is then a single version compare
 template<typename Component>
 class ComponentWrapper : public ComponentWrapperGeneric
 {
 public:
+    using Reference = Internal::ComponentReference<Component>;
+    using Pointer = std::remove_reference_t<Reference>*;
+
     ComponentWrapper(X::Space& space, X::Entity entity) : ComponentWrapperGeneric(space, entity)
     {}
 
     ComponentWrapper(X::Space* space, X::Entity entity) : ComponentWrapperGeneric(space, entity)
     {}
 
+    // The generic wrapper's version may belong to another component's cache
     ComponentWrapper(ComponentWrapperGeneric& generic) : ComponentWrapperGeneric(generic)
-    {}
+    {
+        cachedVersion = 0;
+    }
 
-    [[nodiscard]] Component* operator->() const
+    [[nodiscard]] Pointer operator->() const
     {
-        return &space->GetComponentTemporary<Component>(entity);
+        return &GetComponent();
     }
 
-    [[nodiscard]] Component& GetComponent() const
+    [[nodiscard]] Reference GetComponent() const
     {
-        return space->GetComponentTemporary<Component>(entity);
+        if (cachedVersion != space->GetStructuralVersion())
+        {
+            cachedComponent = &space->GetComponentTemporary<Component>(entity);
+            cachedVersion = space->GetStructuralVersion();
+        }
+        return *cachedComponent;
     }
 
     [[nodiscard]] bool HasComponent() const
     {
         return space->HasComponent<Component>(entity);
     }
+
+private:
+    mutable Pointer cachedComponent{ nullptr };
 };
 } // namespace X
@@ -30,6 +30,8 @@ public:
         *this = other;
     }
 
+    BitSet& operator=(const BitSet& other) = default;
+
     [[nodiscard]] const Internal::BitSetValue& operator[](size_t index) const
     {
         return bitSet[index];
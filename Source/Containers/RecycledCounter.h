@@ -1,6 +1,7 @@
 #pragma once
 
-#include <stack>
+#include <vector>
+
 // CounterType must be convertable to T
 template<typename T>
 class RecycledCounter
@@ -12,8 +13,8 @@ public:
         // Try to pop a recycled ID
         if (!freeIds.empty())
         {
-            nextId = freeIds.top();
-            freeIds.pop();
+            nextId = freeIds.back();
+            freeIds.pop_back();
         }
         else // No recycled IDs available, create a new one
         {
@@ -31,13 +32,24 @@ public:
     void RecycleId(T id)
     {
         // Add to the free list
-        freeIds.emplace(id);
+        freeIds.emplace_back(id);
 #if defined(ALLOY_DEBUG)
         // Remove from the live list
         existingIds.erase(id);
 #endif
     }
 
+    // Frees every ID at once, IDs are then given out from zero again
+    // The free list keeps its capacity
+    void Reset()
+    {
+        currentId = T{};
+        freeIds.clear();
+#if defined(ALLOY_DEBUG)
+        existingIds.clear();
+#endif
+    }
+
     // Current ID is always the next one to give
     // Thus it is returning the count
     [[nodiscard]] T GetCurrentCount() const
@@ -45,6 +57,12 @@ public:
         return currentId;
     }
 
+    // Bytes held by recycled IDs waiting to be reused
+    [[nodiscard]] size_t GetFreeIdBytes() const
+    {
+        return freeIds.capacity() * sizeof(T);
+    }
+
 #if defined(ALLOY_DEBUG)
     [[nodiscard]] const std::unordered_set<T>& GetExistingIds() const
     {
@@ -54,7 +72,7 @@ public:
 
 #ifdef ALLOY_EXPOSE_INTERNALS
     // Returns all the free entity IDs
-    [[nodiscard]] const std::stack<T>& GetFreeIds() const
+    [[nodiscard]] const std::vector<T>& GetFreeIds() const
     {
         return freeIds;
     }
@@ -64,8 +82,9 @@ public:
 private:
     // If there are no recycled entities, used to create a new, unique, id
     T currentId{};
-    // Entity recycling
-    std::stack<T> freeIds{};
+    // Entity recycling, used as a stack
+    // A vector keeps its capacity once popped, so recycling IDs never reallocates after warming up
+    std::vector<T> freeIds{};
 #if defined(ALLOY_DEBUG)
     // Tracking existing Ids
     std::unordered_set<T> existingIds{};
@@ -3,10 +3,17 @@
 #include "Archetype.h"
 #include "ArchetypeMap.h"
 #include "Entity.h"
+#include "Hierarchy.h"
+#include "QueryTerms.h"
+#include "SparseStorage.h"
 
 #include "Containers/RecycledCounter.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
 #include <stack>
+#include <tuple>
 #include <unordered_set>
 
 namespace X::Internal
@@ -22,6 +29,9 @@ public:
     // Uses the next available ID if no recycled entity ID exists
     [[nodiscard]] Entity CreateEntity()
     {
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+        ScopedLatency latency(StructuralOperation::CreateEntity);
+#endif
         IdType nextId = recycledCounter.GetNextId();
         Entity newEntity{ nextId, GetGeneration(nextId) };
         Archetype* baseArchetype = archetypeMap.GetBaseArchetype();
@@ -38,6 +48,10 @@ public:
     {
         // Check to assure invalid entities aren't being destroyed
         ALLOY_ASSERT(IsValid(entity), "Invalid entity was destroyed");
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+        ScopedLatency latency(StructuralOperation::DestroyEntity);
+#endif
+        ++structuralVersion;
 
         if constexpr (DestroyFromLookup)
         {
@@ -48,81 +62,280 @@ public:
             archetypeLookup[entity] = InvalidArchetype;
 #endif
         }
+        hierarchy.RemoveEntity(entity);
+        sparseStorage.RemoveEntity(entity);
         InvalidateEntity(entity);
         recycledCounter.RecycleId(entity);
     }
 
+    // Destroys every entity at once
+    // Each pool's columns are destroyed in a single pass and keep their capacity, every generation is bumped together
+    // Component destructors must not create or destroy entities, unlike with DestroyEntity
+    void Clear()
+    {
+        ++structuralVersion;
+        archetypeMap.ClearArchetypes();
+        hierarchy.Clear();
+        sparseStorage.Clear();
+
+        // Every ID given out so far is invalidated, free ones included, so IDs can be handed out from zero again
+        const auto issuedEnd = generationLookup.begin() + recycledCounter.GetCurrentCount();
+        for (auto generation = generationLookup.begin(); generation != issuedEnd; ++generation)
+            ++*generation;
+#ifdef ALLOY_DEBUG
+        std::fill(archetypeLookup.begin(), archetypeLookup.end(), InvalidArchetype);
+#endif
+        recycledCounter.Reset();
+    }
+
+    [[nodiscard]] uint64_t GetStructuralVersion() const
+    {
+        return structuralVersion;
+    }
+
+    // For operations outside of the entity manager that move rows, such as sorting
+    void IncrementStructuralVersion()
+    {
+        ++structuralVersion;
+    }
+
     void InvalidateEntity(const Entity entity)
     {
         ++generationLookup[entity];
     }
 
     template<typename Component, typename... Args>
-    Component& EmplaceComponent(const Entity entity, Args&&... args)
+    ComponentReference<Component> EmplaceComponent(const Entity entity, Args&&... args)
     {
         ALLOY_ASSERT(HasComponent<Component>(entity) == false, "Entity already has the component that is being added.");
-        // Get the current, now old, archetype
-        Archetype* oldArchetype = archetypeLookup[entity];
-        // Try to find an archetype given the old archetype
-        Archetype* newArchetype = archetypeMap.GetForwardArchetype<Component>(oldArchetype);
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+        ScopedLatency latency(StructuralOperation::AddComponent, archetypeMap.GetLastPath());
+#endif
+        ++structuralVersion;
+        // Sparse components never move the entity between archetypes
+        if constexpr (IsSparseComponent<Component>)
+        {
+            return sparseStorage.Get<Component>().Emplace(entity, std::forward<Args>(args)...);
+        }
+        else if constexpr (IsSharedComponent<Component>)
+        {
+            if constexpr (std::is_aggregate_v<Component>)
+                return AddSharedComponent(entity, Component{ std::forward<Args>(args)... });
+            else
+                return AddSharedComponent(entity, Component(std::forward<Args>(args)...));
+        }
+        else
+        {
+            // Get the current, now old, archetype
+            Archetype* oldArchetype = archetypeLookup[entity];
+            // Try to find an archetype given the old archetype
+            Archetype* newArchetype = archetypeMap.GetForwardArchetype<Component>(oldArchetype);
 
-        //#ifdef ALLOY_DEBUG
-        //        archetypeLookup[entity] = InvalidArchetype;
-        //#endif
+            //#ifdef ALLOY_DEBUG
+            //        archetypeLookup[entity] = InvalidArchetype;
+            //#endif
 
-        archetypeLookup[entity] = newArchetype;
-        // Transfer the entity over
-        Component& newComponent = newArchetype->TransferEntityEmplace<Component>(
-            oldArchetype,
-            entity,
-            std::forward<Args>(args)...);
-        return newComponent;
+            archetypeLookup[entity] = newArchetype;
+            // Transfer the entity over
+            Component& newComponent = newArchetype->TransferEntityEmplace<Component>(
+                oldArchetype,
+                entity,
+                std::forward<Args>(args)...);
+            return newComponent;
+        }
     }
 
     template<typename Component>
     void InsertComponent(const Entity entity, const Component& component = {})
     {
         ALLOY_ASSERT(HasComponent<Component>(entity) == false, "Entity already has the component that is being added.");
-        // Get the current, now old, archetype
-        Archetype* oldArchetype = archetypeLookup[entity];
-        // Try to find an archetype given the old archetype
-        Archetype* newArchetype = archetypeMap.GetForwardArchetype<Component>(oldArchetype);
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+        ScopedLatency latency(StructuralOperation::AddComponent, archetypeMap.GetLastPath());
+#endif
+        ++structuralVersion;
+        if constexpr (IsSparseComponent<Component>)
+        {
+            sparseStorage.Get<Component>().Emplace(entity, component);
+        }
+        else if constexpr (IsSharedComponent<Component>)
+        {
+            AddSharedComponent(entity, Component(component));
+        }
+        else
+        {
+            // Get the current, now old, archetype
+            Archetype* oldArchetype = archetypeLookup[entity];
+            // Try to find an archetype given the old archetype
+            Archetype* newArchetype = archetypeMap.GetForwardArchetype<Component>(oldArchetype);
 
-        archetypeLookup[entity] = newArchetype;
-        // Transfer the entity over
-        newArchetype->TransferEntityInsert<Component>(
-            oldArchetype,
-            entity,
-            component);
+            archetypeLookup[entity] = newArchetype;
+            // Transfer the entity over
+            newArchetype->TransferEntityInsert<Component>(
+                oldArchetype,
+                entity,
+                component);
+        }
     }
 
     template<typename Component>
     void RemoveComponent(const Entity entity)
     {
         ALLOY_ASSERT(HasComponent<Component>(entity) == true, "Entity does not have the component that is being removed.");
-        // Get the current, now old, archetype
-        Archetype* oldArchetype = archetypeLookup[entity];
-        // Try to find an archetype given the old archetype
-        Archetype* newArchetype = archetypeMap.template GetBackwardArchetype<Component>(oldArchetype);
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+        ScopedLatency latency(StructuralOperation::RemoveComponent, archetypeMap.GetLastPath());
+#endif
+        ++structuralVersion;
+        if constexpr (IsSparseComponent<Component>)
+        {
+            sparseStorage.Get<Component>().Remove(entity);
+        }
+        else
+        {
+            // Get the current, now old, archetype
+            Archetype* oldArchetype = archetypeLookup[entity];
+            // Try to find an archetype given the old archetype
+            Archetype* newArchetype = archetypeMap.template GetBackwardArchetype<Component>(oldArchetype);
 
-        archetypeLookup[entity] = newArchetype;
-        // Transfer the entity over
-        newArchetype->TransferEntityRemove<Component>(oldArchetype, entity);
+            archetypeLookup[entity] = newArchetype;
+            // Transfer the entity over
+            newArchetype->TransferEntityRemove<Component>(oldArchetype, entity);
+        }
     }
 
     // Entity ID -> ComponentMask -> Archetype -> Component
     template<typename Component>
-    [[nodiscard]] Component& GetComponent(const Entity entity)
+    [[nodiscard]] ComponentReference<Component> GetComponent(const Entity entity)
     {
         ALLOY_ASSERT(HasComponent<Component>(entity), "Entity does not hold the requested component.");
-        return archetypeLookup[entity]->GetComponent<Component>(entity);
+        if constexpr (IsSparseComponent<Component>)
+            return sparseStorage.Get<Component>().Get(entity);
+        else
+            return archetypeLookup[entity]->GetComponent<Component>(entity);
     }
 
     // Entity ID -> ComponentMask -> Archetype -> Components
     template<typename... Components, typename UpdateFunction>
     void GetComponents(const Entity entity, UpdateFunction&& updateFunction)
     {
-        archetypeLookup[entity]->GetComponents<Components...>(entity, std::forward<UpdateFunction>(updateFunction));
+        if constexpr ((IsSparseComponent<Components> || ...))
+            updateFunction(GetComponent<Components>(entity)...);
+        else
+            archetypeLookup[entity]->GetComponents<Components...>(entity, std::forward<UpdateFunction>(updateFunction));
+    }
+
+    // Joins from a sparse set's entities instead of scanning archetypes
+    // Used when the sparse set holds fewer entities than the matching archetypes
+    template<bool PassEntity, typename... Terms, typename UpdateFunction, typename... Args>
+    void UpdateFromSparseSet(const SparseSetInterface& drivingSet,
+                             const std::array<uint8_t*, sizeof...(Terms)>& externalData,
+                             UpdateFunction&& updateFunction, Args&&... args)
+    {
+        for (const Entity entity : drivingSet.GetEntities())
+        {
+            Archetype* archetype = archetypeLookup[entity];
+            if (!HasAllComponents(MaskTypesOf<Terms...>{}, archetype->GetComponentMask()))
+                continue;
+
+            size_t term = 0;
+            if (!(TermTraits<Terms>::Accept(externalData[term++], entity) && ...))
+                continue;
+
+            archetype->GetPool().UpdateRow<PassEntity, Terms...>(
+                archetype->GetIndex(entity),
+                externalData,
+                std::forward<UpdateFunction>(updateFunction),
+                std::forward<Args>(args)...);
+        }
+    }
+
+    // Calls function(input index, entity, components...) for every given entity, in list order
+    // With many entities each one's dependent loads (archetype lookup -> entity map -> row) are prefetched in stages
+    // ahead of its use, the resolved component addresses are carried to the visit through a small ring
+    template<typename... Components, typename Function>
+    void Gather(const std::vector<Entity>& entities, Function&& function)
+    {
+        static_assert(((!IsSparseComponent<Components>) && ...), "Gathers do not support sparse components.");
+        constexpr size_t Distance = GatherPrefetchDistance;
+        constexpr size_t RingMask = 2 * Distance - 1;
+        static_assert((Distance & (Distance - 1)) == 0, "Gather prefetch distance must be a power of two.");
+        const size_t count = entities.size();
+        if (archetypeLookup.size() < GatherPrefetchMinimumEntities)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                ALLOY_ASSERT(IsValid(entities[i]), "Gathered entity is not valid.");
+                Archetype* archetype = archetypeLookup[entities[i]];
+                ALLOY_ASSERT(HasAllComponents(MaskTypesOf<Components...>{}, archetype->GetComponentMask()), "Gathered entity does not hold every component.");
+                const Pool::IndexType row = archetype->GetIndex(entities[i]);
+                function(i, entities[i], archetype->GetPool().GetComponent<Components>(row)...);
+            }
+            return;
+        }
+
+        using Addresses = std::tuple<std::remove_reference_t<ComponentReference<Components>>*...>;
+        std::array<Addresses, 2 * Distance> ring{};
+        const auto resolve = [this, &entities, &ring](const size_t index) {
+            ALLOY_ASSERT(IsValid(entities[index]), "Gathered entity is not valid.");
+            Archetype* archetype = archetypeLookup[entities[index]];
+            ALLOY_ASSERT(HasAllComponents(MaskTypesOf<Components...>{}, archetype->GetComponentMask()), "Gathered entity does not hold every component.");
+            const Pool::IndexType row = archetype->GetIndex(entities[index]);
+            Pool& pool = archetype->GetPool();
+            Addresses& addresses = ring[index & RingMask];
+            addresses = Addresses{ &pool.GetComponent<Components>(row)... };
+            std::apply([](const auto*... components) {
+                (ALLOY_PREFETCH(components), ...);
+            }, addresses);
+        };
+
+        for (size_t i = 0; i < std::min(Distance, count); ++i)
+            resolve(i);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i + 3 * Distance < count)
+                ALLOY_PREFETCH(&archetypeLookup[entities[i + 3 * Distance]]);
+            if (i + 2 * Distance < count)
+                archetypeLookup[entities[i + 2 * Distance]]->PrefetchIndex(entities[i + 2 * Distance]);
+            if (i + Distance < count)
+                resolve(i + Distance);
+
+            std::apply([&function, &entities, i](auto*... components) {
+                function(i, entities[i], *components...);
+            }, ring[i & RingMask]);
+        }
+    }
+
+    [[nodiscard]] SparseStorage& GetSparseStorage()
+    {
+        return sparseStorage;
+    }
+
+    // Visits every non-root hierarchy node, parents before children, passing the parent's components
+    // Component rows are resolved once per structural version, then every update walks the nodes in depth order
+    // over packed copies of their components (for trivially copyable components)
+    template<typename... Components, typename UpdateFunction, typename... Args>
+    void UpdateHierarchy(UpdateFunction&& updateFunction, Args&&... args)
+    {
+        static_assert(((IsColumnComponent<Components> || IsTagComponent<Components>) && ...), "Hierarchy updates do not support sparse or shared components.");
+        UpdateHierarchyHelper<Components...>(
+            std::index_sequence_for<Components...>{},
+            std::forward<UpdateFunction>(updateFunction),
+            std::forward<Args>(args)...);
+    }
+
+    [[nodiscard]] Hierarchy& GetHierarchy()
+    {
+        return hierarchy;
+    }
+
+    [[nodiscard]] EntityManagerMemoryStats GetMemoryStats() const
+    {
+        return EntityManagerMemoryStats{
+            Internal::GetReservedBytes(archetypeLookup),
+            Internal::GetReservedBytes(generationLookup),
+            recycledCounter.GetFreeIdBytes(),
+            hierarchy.GetReservedBytes(),
+            sparseStorage.GetReservedBytes()
+        };
     }
 
     // Entity ID -> ComponentMask -> Archetype -> Check
@@ -131,7 +344,10 @@ public:
     {
         ALLOY_ASSERT(entity < archetypeLookup.size(), "Given bad entity.");
         ALLOY_ASSERT(archetypeLookup[entity] != nullptr, "Given bad entity.");
-        return archetypeLookup[entity]->GetComponentMask()[GetComponentId<Component>::value] == BitSet::True;
+        if constexpr (IsSparseComponent<Component>)
+            return sparseStorage.Get<Component>().Contains(entity);
+        else
+            return archetypeLookup[entity]->GetComponentMask()[GetComponentId<Component>::value] != BitSet::False;
     }
 
     [[nodiscard]] bool IsValid(const Entity entity)
@@ -151,13 +367,144 @@ public:
     {
         ALLOY_ASSERT(entity < archetypeLookup.size(), "Given bad entity.");
         ALLOY_ASSERT(archetypeLookup[entity] != nullptr, "Given bad entity.");
-        return archetypeLookup[entity]->GetComponentMask()[componentId] == BitSet::True;
+        return archetypeLookup[entity]->GetComponentMask()[componentId] != BitSet::False;
     }
 #endif
 
 private:
     static constexpr Archetype* InvalidArchetype = nullptr;
 
+    // Moves the entity to the archetype holding the given shared value
+    template<typename Component>
+    const Component& AddSharedComponent(const Entity entity, Component&& value)
+    {
+        Archetype* oldArchetype = archetypeLookup[entity];
+        Archetype* newArchetype = archetypeMap.GetSharedForwardArchetype<Component>(oldArchetype, std::move(value));
+
+        archetypeLookup[entity] = newArchetype;
+        newArchetype->TransferEntityShared(oldArchetype, entity);
+        return newArchetype->GetComponent<Component>(entity);
+    }
+
+    // Identifies the components a hierarchy row cache was resolved for
+    template<typename... Components>
+    static constexpr char HierarchyRowsKey = 0;
+
+    // Byte offset of every component within a packed hierarchy row, followed by the row stride in max_align_t units
+    template<typename... Components>
+    static constexpr std::array<size_t, sizeof...(Components) + 1> MakePackedOffsets()
+    {
+        constexpr std::array<size_t, sizeof...(Components)> sizes{ sizeof(Components)... };
+        constexpr std::array<size_t, sizeof...(Components)> alignments{ alignof(Components)... };
+        std::array<size_t, sizeof...(Components) + 1> offsets{};
+        size_t offset = 0;
+        for (size_t i = 0; i < sizes.size(); ++i)
+        {
+            offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+        offsets.back() = (offset + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        return offsets;
+    }
+
+    // Tags have no row, their packed copy is left as is
+    template<typename Component>
+    static void CopyHierarchyComponent(void* destination, const void* source)
+    {
+        if constexpr (!IsTagComponent<Component>)
+            std::memcpy(destination, source, sizeof(Component));
+    }
+
+    // Resolves every node's component rows, nullptr rows for nodes missing a component
+    template<typename... Components, size_t... Is>
+    void ResolveHierarchyRows(const std::vector<Hierarchy::Node>& nodes, std::vector<void*>& rowCache, std::index_sequence<Is...>)
+    {
+        constexpr size_t ComponentCount = sizeof...(Components);
+        rowCache.resize(nodes.size() * ComponentCount);
+        for (size_t index = 0; index < nodes.size(); ++index)
+        {
+            void** nodeRows = rowCache.data() + index * ComponentCount;
+            Archetype* archetype = archetypeLookup[nodes[index].entity];
+            const BitSet& componentMask = archetype->GetComponentMask();
+            if (((componentMask[GetComponentId<Components>::value] != BitSet::False) && ...))
+                ((nodeRows[Is] = &archetype->GetComponent<Components>(nodes[index].entity)), ...);
+            else
+                ((nodeRows[Is] = nullptr), ...);
+        }
+    }
+
+    template<typename... Components, size_t... Is, typename UpdateFunction, typename... Args>
+    void UpdateHierarchyHelper(std::index_sequence<Is...>, UpdateFunction&& updateFunction, Args&&... args)
+    {
+        constexpr size_t ComponentCount = sizeof...(Components);
+        const std::vector<Hierarchy::Node>& nodes = hierarchy.GetNodes();
+        std::vector<void*>& rowCache = hierarchy.GetRowCache();
+        // Rows only move with structural changes, so they are not looked up again on every update
+        if (!hierarchy.IsRowCacheCurrent(structuralVersion, &HierarchyRowsKey<Components...>))
+        {
+            ResolveHierarchyRows<Components...>(nodes, rowCache, std::index_sequence<Is...>{});
+            hierarchy.SetRowCacheCurrent(structuralVersion, &HierarchyRowsKey<Components...>);
+        }
+        // Nodes missing a component are skipped and look like roots to their children
+        const auto holdsComponents = [&rowCache](const size_t index) {
+            if constexpr (ComponentCount == 0)
+                return true;
+            else
+                return rowCache[index * ComponentCount] != nullptr;
+        };
+
+        if constexpr (((std::is_trivially_copyable_v<Components> && alignof(Components) <= alignof(std::max_align_t)) && ...))
+        {
+            // Each node's components are copied into a depth-ordered packed row, updated there and copied back
+            // so a child reads its parent's components from the packed rows instead of the parent's archetype
+            constexpr std::array<size_t, ComponentCount + 1> Offsets = MakePackedOffsets<Components...>();
+            constexpr size_t Stride = Offsets.back();
+            std::vector<std::max_align_t>& packedRows = hierarchy.GetPackedRows();
+            packedRows.resize(nodes.size() * Stride);
+
+            for (size_t index = 0; index < nodes.size(); ++index)
+            {
+                if (!holdsComponents(index))
+                    continue;
+                void* const* nodeRows = rowCache.data() + index * ComponentCount;
+                uint8_t* packedRow = reinterpret_cast<uint8_t*>(packedRows.data() + index * Stride);
+                (CopyHierarchyComponent<Components>(packedRow + Offsets[Is], nodeRows[Is]), ...);
+
+                // Roots are updated along with every other parentless entity
+                const Hierarchy::Node& node = nodes[index];
+                if (node.parentIndex == Hierarchy::InvalidIndex)
+                    continue;
+
+                uint8_t* parentRow = holdsComponents(node.parentIndex) ? reinterpret_cast<uint8_t*>(packedRows.data() + node.parentIndex * Stride) : nullptr;
+                updateFunction(
+                    node.entity,
+                    *reinterpret_cast<Components*>(packedRow + Offsets[Is])...,
+                    (parentRow != nullptr ? reinterpret_cast<Components*>(parentRow + Offsets[Is]) : nullptr)...,
+                    std::forward<Args>(args)...);
+                (CopyHierarchyComponent<Components>(nodeRows[Is], packedRow + Offsets[Is]), ...);
+            }
+        }
+        else
+        {
+            // Components that cannot be copied bytewise are updated in place through the cached rows
+            for (size_t index = 0; index < nodes.size(); ++index)
+            {
+                const Hierarchy::Node& node = nodes[index];
+                if (!holdsComponents(index) || node.parentIndex == Hierarchy::InvalidIndex)
+                    continue;
+
+                void* const* nodeRows = rowCache.data() + index * ComponentCount;
+                void* const* parentRows = rowCache.data() + node.parentIndex * ComponentCount;
+                updateFunction(
+                    node.entity,
+                    *static_cast<Components*>(nodeRows[Is])...,
+                    static_cast<Components*>(parentRows[Is])...,
+                    std::forward<Args>(args)...);
+            }
+        }
+    }
+
     void archetypeLookupAssureSizeAndSet(IdType entity, Archetype* RuntimeArchetype)
     {
         if (archetypeLookup.size() <= entity)
@@ -201,6 +548,12 @@ private:
     SparseSetContainer<Archetype*> archetypeLookup{ nullptr };
     ArchetypeMap& archetypeMap;
     SparseSetContainer<GenerationType> generationLookup{ 0 };
+    Hierarchy hierarchy{};
+    SparseStorage sparseStorage{};
+    // Incremented by every operation that may move component rows or reallocate their storage
+    // Creating an entity does not, it only appends to the base archetype which holds no components
+    // Starts at one so that zero can never match
+    uint64_t structuralVersion{ 1 };
 };
 
 } // namespace X::Internal
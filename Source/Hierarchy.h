@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Alloy/AlloyConfig.h"
+#include "Entity.h"
+#include "MemoryStats.h"
+
+namespace X::Internal
+{
+
+// Parent/child relationships between entities of a space
+// Relationships are stored intrusively (per entity ID) and flattened into a depth-ordered node list on demand
+// so that parents are always visited, and packed, before their children
+class Hierarchy
+{
+public:
+    static constexpr size_t InvalidIndex = std::numeric_limits<size_t>::max();
+
+    struct Node
+    {
+        Entity entity;
+        // Index of the parent's node, InvalidIndex for roots
+        size_t parentIndex;
+    };
+
+    // Sets the parent of a given child, replacing any existing parent
+    void SetParent(const Entity child, const Entity parent)
+    {
+        ALLOY_ASSERT(child != parent, "An entity cannot be its own parent.");
+        ALLOY_ASSERT(!IsAncestor(child, parent), "Setting this parent would create a cycle.");
+        RelationsAssureSize(child > parent ? child : parent);
+
+        if (IsSet(relations[child].parent))
+            Detach(child);
+
+        Relation& childRelation = relations[child];
+        Relation& parentRelation = relations[parent];
+        childRelation.parent = parent;
+        childRelation.previousSibling = Entity();
+        childRelation.nextSibling = parentRelation.firstChild;
+        if (IsSet(parentRelation.firstChild))
+            relations[parentRelation.firstChild].previousSibling = child;
+        parentRelation.firstChild = child;
+        dirty = true;
+    }
+
+    // Detaches a child from its parent, if it has one
+    void RemoveParent(const Entity child)
+    {
+        if (HasParent(child))
+            Detach(child);
+    }
+
+    [[nodiscard]] bool HasParent(const Entity child) const
+    {
+        return child < relations.size() && IsSet(relations[child].parent);
+    }
+
+    // Returns an invalid entity if the child has no parent
+    [[nodiscard]] Entity GetParent(const Entity child) const
+    {
+        return child < relations.size() ? relations[child].parent : Entity();
+    }
+
+    template<typename Function>
+    void EachChild(const Entity parent, Function&& function) const
+    {
+        if (parent >= relations.size())
+            return;
+        for (Entity child = relations[parent].firstChild; IsSet(child); child = relations[child].nextSibling)
+            function(child);
+    }
+
+    // Must be called before an entity is destroyed
+    // Detaches the entity from its parent, turning its children into roots
+    void RemoveEntity(const Entity entity)
+    {
+        if (entity >= relations.size())
+            return;
+
+        if (IsSet(relations[entity].parent))
+            Detach(entity);
+
+        Entity child = relations[entity].firstChild;
+        if (!IsSet(child))
+            return;
+
+        while (IsSet(child))
+        {
+            Relation& childRelation = relations[child];
+            child = childRelation.nextSibling;
+            childRelation.parent = Entity();
+            childRelation.previousSibling = Entity();
+            childRelation.nextSibling = Entity();
+        }
+        relations[entity].firstChild = Entity();
+        dirty = true;
+    }
+
+    // Removes every relationship at once, keeping the storage
+    void Clear()
+    {
+        std::fill(relations.begin(), relations.end(), Relation{});
+        nodes.clear();
+        dirty = false;
+        rowCacheVersion = 0;
+    }
+
+    // Returns all entities that are part of a hierarchy in breadth-first (depth) order
+    // Roots are only included if they have children
+    [[nodiscard]] const std::vector<Node>& GetNodes()
+    {
+        if (dirty)
+            RebuildNodes();
+        return nodes;
+    }
+
+    // Component row addresses per node, in node order, as resolved by the last hierarchy update
+    [[nodiscard]] std::vector<void*>& GetRowCache()
+    {
+        return rowCache;
+    }
+
+    // The row cache holds the given components' rows until the nodes are rebuilt or the space's rows move
+    [[nodiscard]] bool IsRowCacheCurrent(const uint64_t structuralVersion, const void* componentsKey) const
+    {
+        return rowCacheVersion == structuralVersion && rowCacheKey == componentsKey;
+    }
+
+    void SetRowCacheCurrent(const uint64_t structuralVersion, const void* componentsKey)
+    {
+        rowCacheVersion = structuralVersion;
+        rowCacheKey = componentsKey;
+    }
+
+    // Depth-ordered copies of the node components, reused between hierarchy updates
+    [[nodiscard]] std::vector<std::max_align_t>& GetPackedRows()
+    {
+        return packedRows;
+    }
+
+    [[nodiscard]] size_t GetReservedBytes() const
+    {
+        return Internal::GetReservedBytes(relations) + Internal::GetReservedBytes(nodes) + Internal::GetReservedBytes(rowCache) + Internal::GetReservedBytes(packedRows);
+    }
+
+private:
+    struct Relation
+    {
+        Entity parent{};
+        Entity firstChild{};
+        Entity previousSibling{};
+        Entity nextSibling{};
+    };
+
+    [[nodiscard]] static bool IsSet(const Entity entity)
+    {
+        return entity.GetId() != INVALID_ENTITY_ID;
+    }
+
+    [[nodiscard]] bool IsAncestor(const Entity ancestor, Entity entity) const
+    {
+        while (entity < relations.size() && IsSet(relations[entity].parent))
+        {
+            entity = relations[entity].parent;
+            if (entity == ancestor)
+                return true;
+        }
+        return false;
+    }
+
+    void Detach(const Entity child)
+    {
+        Relation& childRelation = relations[child];
+        if (IsSet(childRelation.previousSibling))
+            relations[childRelation.previousSibling].nextSibling = childRelation.nextSibling;
+        else
+            relations[childRelation.parent].firstChild = childRelation.nextSibling;
+        if (IsSet(childRelation.nextSibling))
+            relations[childRelation.nextSibling].previousSibling = childRelation.previousSibling;
+
+        childRelation.parent = Entity();
+        childRelation.previousSibling = Entity();
+        childRelation.nextSibling = Entity();
+        dirty = true;
+    }
+
+    void RebuildNodes()
+    {
+        nodes.clear();
+
+        // Roots are entities with children but without a parent
+        // A root's own handle is recovered through its first child
+        for (size_t id = 0; id < relations.size(); ++id)
+        {
+            const Relation& relation = relations[id];
+            if (!IsSet(relation.parent) && IsSet(relation.firstChild))
+                nodes.emplace_back(Node{ relations[relation.firstChild].parent, InvalidIndex });
+        }
+
+        // Breadth-first, so every node is placed after its parent and siblings are packed together
+        for (size_t index = 0; index < nodes.size(); ++index)
+            EachChild(nodes[index].entity, [this, index](const Entity child) {
+                nodes.emplace_back(Node{ child, index });
+            });
+
+        dirty = false;
+        rowCacheVersion = 0;
+    }
+
+    void RelationsAssureSize(IdType entity)
+    {
+        if (relations.size() <= entity)
+        {
+            IdType v = entity + 1;
+            --v;
+            v |= v >> 1;
+            v |= v >> 2;
+            v |= v >> 4;
+            v |= v >> 8;
+            v |= v >> 16;
+            ++v;
+            relations.resize(v);
+        }
+    }
+
+    // Entity ID -> Relation
+    SparseSetContainer<Relation> relations{};
+    // Depth-ordered nodes, rebuilt when dirty
+    std::vector<Node> nodes{};
+    std::vector<void*> rowCache{};
+    // Structural version the row cache was resolved at, zero never matches
+    uint64_t rowCacheVersion{ 0 };
+    const void* rowCacheKey{ nullptr };
+    std::vector<std::max_align_t> packedRows{};
+    bool dirty{ false };
+};
+
+} // namespace X::Internal
@@ -0,0 +1,244 @@
+#pragma once
+
+#ifdef ALLOY_INSTRUMENTATION
+
+    #include <chrono>
+    #include <functional>
+    #include <mutex>
+    #include <ostream>
+    #include <string>
+    #include <thread>
+    #include <typeinfo>
+    #include <vector>
+
+    #include "Alloy/AlloyConfig.h"
+
+namespace X
+{
+
+class Archetype;
+
+// Entities moved along one archetype graph edge of a space
+struct ArchetypeTransitionStats
+{
+    const Archetype* from;
+    const Archetype* to;
+    size_t componentId;
+    // False if the component was removed
+    bool added;
+    size_t moves;
+    // Row bytes copied, the entity included
+    size_t bytes;
+};
+
+// Totals for one update query type in one space
+struct UpdateStats
+{
+    // Terms of the update, as named by typeid
+    std::string query;
+    size_t spaceId;
+    size_t calls;
+    size_t rows;
+    // Includes empty archetypes
+    size_t archetypes;
+    size_t emptyArchetypes;
+    std::chrono::nanoseconds time;
+};
+
+// Per query and per space update statistics, compiled in with ALLOY_INSTRUMENTATION
+// Statistics are always gathered, trace events only while tracing is enabled
+class Instrumentation
+{
+public:
+    // Statistics of every query and space that has been updated since the last reset
+    [[nodiscard]] static std::vector<UpdateStats> GetUpdateStats()
+    {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        std::vector<UpdateStats> updateStats{};
+        for (const std::vector<UpdateStats>& spaceStats : state.stats)
+            for (const UpdateStats& stats : spaceStats)
+                if (stats.calls > 0)
+                    updateStats.emplace_back(stats);
+        return updateStats;
+    }
+
+    static void Reset()
+    {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (std::vector<UpdateStats>& spaceStats : state.stats)
+            for (UpdateStats& stats : spaceStats)
+                stats = UpdateStats{ stats.query, stats.spaceId, 0, 0, 0, 0, std::chrono::nanoseconds(0) };
+        state.events.clear();
+    }
+
+    // Trace events are kept in memory until written or reset
+    static void SetTracing(bool enabled)
+    {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.tracing = enabled;
+    }
+
+    // Writes the recorded trace events in the Chrome trace event format (chrome://tracing, Perfetto)
+    static void WriteChromeTrace(std::ostream& stream)
+    {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        stream << "{\"traceEvents\":[";
+        for (size_t i = 0; i < state.events.size(); ++i)
+        {
+            const TraceEvent& event = state.events[i];
+            const UpdateStats& stats = state.stats[event.queryId][event.spaceId];
+            if (i > 0)
+                stream << ",";
+            stream << "\n{\"name\":\"";
+            WriteEscaped(stream, stats.query);
+            stream << "\",\"cat\":\"Update\",\"ph\":\"X\",\"pid\":0"
+                   << ",\"tid\":" << event.threadId
+                   << ",\"ts\":" << std::chrono::duration<double, std::micro>(event.start).count()
+                   << ",\"dur\":" << std::chrono::duration<double, std::micro>(event.duration).count()
+                   << ",\"args\":{\"space\":" << event.spaceId
+                   << ",\"rows\":" << event.rows
+                   << ",\"archetypes\":" << event.archetypes << "}}";
+        }
+        stream << "\n]}\n";
+    }
+
+    // Unique ID per update term list, used to index statistics
+    template<typename... Terms>
+    [[nodiscard]] static size_t GetQueryId()
+    {
+        static const size_t queryId = RegisterQuery(GetQueryName<Terms...>());
+        return queryId;
+    }
+
+    static void Record(size_t queryId, size_t spaceId, size_t rows, size_t archetypes, size_t emptyArchetypes,
+                       std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        std::vector<UpdateStats>& spaceStats = state.stats[queryId];
+        if (spaceId >= spaceStats.size())
+            for (size_t id = spaceStats.size(); id <= spaceId; ++id)
+                spaceStats.emplace_back(UpdateStats{ state.queryNames[queryId], id, 0, 0, 0, 0, std::chrono::nanoseconds(0) });
+
+        UpdateStats& stats = spaceStats[spaceId];
+        ++stats.calls;
+        stats.rows += rows;
+        stats.archetypes += archetypes;
+        stats.emptyArchetypes += emptyArchetypes;
+        stats.time += end - start;
+
+        if (state.tracing)
+            state.events.emplace_back(TraceEvent{
+                queryId,
+                spaceId,
+                std::hash<std::thread::id>()(std::this_thread::get_id()),
+                rows,
+                archetypes,
+                start - state.epoch,
+                end - start });
+    }
+
+private:
+    struct TraceEvent
+    {
+        size_t queryId;
+        size_t spaceId;
+        size_t threadId;
+        size_t rows;
+        size_t archetypes;
+        std::chrono::steady_clock::duration start;
+        std::chrono::steady_clock::duration duration;
+    };
+
+    struct State
+    {
+        std::mutex mutex{};
+        // Query ID -> Space ID -> Statistics
+        std::vector<std::vector<UpdateStats>> stats{};
+        std::vector<std::string> queryNames{};
+        std::vector<TraceEvent> events{};
+        std::chrono::steady_clock::time_point epoch{ std::chrono::steady_clock::now() };
+        bool tracing{ false };
+    };
+
+    [[nodiscard]] static State& GetState()
+    {
+        static State state;
+        return state;
+    }
+
+    template<typename... Terms>
+    [[nodiscard]] static std::string GetQueryName()
+    {
+        std::string name{ "Update<" };
+        ((name += typeid(Terms).name(), name += ","), ...);
+        if (sizeof...(Terms) > 0)
+            name.pop_back();
+        return name + ">";
+    }
+
+    [[nodiscard]] static size_t RegisterQuery(std::string name)
+    {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.queryNames.emplace_back(std::move(name));
+        state.stats.emplace_back();
+        return state.stats.size() - 1;
+    }
+
+    static void WriteEscaped(std::ostream& stream, const std::string& text)
+    {
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                stream << '\\';
+            stream << c;
+        }
+    }
+};
+
+} // namespace X
+
+namespace X::Internal
+{
+
+// Times a single update, recording it when destroyed
+template<typename... Terms>
+class ScopedUpdateTimer
+{
+public:
+    ScopedUpdateTimer(size_t spaceId, size_t rows, size_t archetypes, size_t emptyArchetypes)
+        : spaceId(spaceId),
+          rows(rows),
+          archetypes(archetypes),
+          emptyArchetypes(emptyArchetypes),
+          start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedUpdateTimer()
+    {
+        Instrumentation::Record(Instrumentation::GetQueryId<Terms...>(), spaceId, rows, archetypes, emptyArchetypes, start, std::chrono::steady_clock::now());
+    }
+
+    // Updates joined from a sparse set visit its entities instead of archetype rows
+    void SetRows(size_t visitedRows)
+    {
+        rows = visitedRows;
+    }
+
+private:
+    size_t spaceId;
+    size_t rows;
+    size_t archetypes;
+    size_t emptyArchetypes;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace X::Internal
+
+#endif // ALLOY_INSTRUMENTATION
@@ -0,0 +1,202 @@
+#pragma once
+
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+
+    #include <array>
+    #include <atomic>
+    #include <chrono>
+    #include <cstdint>
+
+    #include "Alloy/AlloyConfig.h"
+
+namespace X
+{
+
+enum class StructuralOperation
+{
+    CreateEntity,
+    DestroyEntity,
+    AddComponent,
+    RemoveComponent,
+    // Building and registering a new archetype, part of an add or remove
+    ArchetypeCreation,
+    // Doubling a pool's columns, part of any operation moving an entity into an archetype
+    PoolGrowth,
+    Count
+};
+
+// How the destination archetype of an add or remove was found
+enum class ArchetypePath
+{
+    // Operation does not look up an archetype (or only touches sparse storage)
+    None,
+    // Cached on the source archetype's graph edge
+    EdgeHit,
+    // Found in the space's archetype map
+    MapHit,
+    // Created
+    NewArchetype,
+    Count
+};
+
+// Log-linear (HDR-style) histogram of nanosecond latencies
+// Values below 2 * SubBucketCount are exact, larger values are bucketed with SubBucketCount buckets per power of two
+// (a relative error under 12.5%)
+// Counters are relaxed atomics, so recording from multiple threads is safe
+class LatencyHistogram
+{
+public:
+    static constexpr size_t SubBucketCount = 8;
+    static constexpr size_t BucketCount = 2 * SubBucketCount + (64 - 4) * SubBucketCount;
+
+    void Record(uint64_t nanoseconds)
+    {
+        buckets[GetBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(nanoseconds, std::memory_order_relaxed);
+        uint64_t currentMax = max.load(std::memory_order_relaxed);
+        while (nanoseconds > currentMax && !max.compare_exchange_weak(currentMax, nanoseconds, std::memory_order_relaxed))
+            ;
+    }
+
+    void Reset()
+    {
+        for (std::atomic<uint64_t>& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t GetCount() const
+    {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t GetTotal() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t GetMax() const
+    {
+        return max.load(std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket holding the given percentile (0 - 100)
+    [[nodiscard]] uint64_t GetPercentile(double percentile) const
+    {
+        const uint64_t recorded = GetCount();
+        if (recorded == 0)
+            return 0;
+
+        const uint64_t target = static_cast<uint64_t>(static_cast<double>(recorded) * percentile / 100.0 + 0.5);
+        uint64_t seen = 0;
+        for (size_t index = 0; index < BucketCount; ++index)
+        {
+            seen += GetBucket(index);
+            if (seen >= target && seen > 0)
+                return index + 1 < BucketCount ? GetBucketLowerBound(index + 1) - 1 : GetMax();
+        }
+        return GetMax();
+    }
+
+    [[nodiscard]] uint64_t GetBucket(size_t index) const
+    {
+        return buckets[index].load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static uint64_t GetBucketLowerBound(size_t index)
+    {
+        if (index < 2 * SubBucketCount)
+            return index;
+        const size_t shift = (index - 2 * SubBucketCount) / SubBucketCount + 1;
+        const uint64_t mantissa = (index - 2 * SubBucketCount) % SubBucketCount + SubBucketCount;
+        return mantissa << shift;
+    }
+
+    [[nodiscard]] static size_t GetBucketIndex(uint64_t value)
+    {
+        if (value < 2 * SubBucketCount)
+            return static_cast<size_t>(value);
+
+        size_t mostSignificantBit = 0;
+        for (uint64_t v = value; v > 1; v >>= 1)
+            ++mostSignificantBit;
+        // Keep the leading bit plus three more as the mantissa
+        const size_t shift = mostSignificantBit - 3;
+        const size_t mantissa = static_cast<size_t>(value >> shift);
+        return 2 * SubBucketCount + (shift - 1) * SubBucketCount + (mantissa - SubBucketCount);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> total{ 0 };
+    std::atomic<uint64_t> max{ 0 };
+};
+
+// Process-wide structural operation latencies, compiled in with ALLOY_LATENCY_HISTOGRAMS
+class LatencyHistograms
+{
+public:
+    [[nodiscard]] static LatencyHistogram& Get(StructuralOperation operation, ArchetypePath path = ArchetypePath::None)
+    {
+        return GetHistograms()[static_cast<size_t>(operation)][static_cast<size_t>(path)];
+    }
+
+    static void Reset()
+    {
+        for (auto& operationHistograms : GetHistograms())
+            for (LatencyHistogram& histogram : operationHistograms)
+                histogram.Reset();
+    }
+
+private:
+    using Histograms = std::array<std::array<LatencyHistogram, static_cast<size_t>(ArchetypePath::Count)>,
+                                  static_cast<size_t>(StructuralOperation::Count)>;
+
+    [[nodiscard]] static Histograms& GetHistograms()
+    {
+        static Histograms histograms{};
+        return histograms;
+    }
+};
+
+} // namespace X
+
+namespace X::Internal
+{
+
+// Records the latency of a structural operation when destroyed
+// The path is read on destruction, so the operation may resolve it while it runs
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(StructuralOperation operation, ArchetypePath* path = nullptr)
+        : operation(operation),
+          path(path),
+          start(std::chrono::steady_clock::now())
+    {
+        if (path != nullptr)
+            *path = ArchetypePath::None;
+    }
+
+    ~ScopedLatency()
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        LatencyHistograms::Get(operation, path != nullptr ? *path : ArchetypePath::None).Record(static_cast<uint64_t>(elapsed.count()));
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    StructuralOperation operation;
+    ArchetypePath* path;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace X::Internal
+
+#endif // ALLOY_LATENCY_HISTOGRAMS
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "ComponentTypeTraits.h"
+
+namespace X
+{
+
+// Bytes are what the containers hold, allocator overhead is not included
+
+struct ColumnMemoryStats
+{
+    Internal::ComponentTypeTraits::ComponentId componentId;
+    size_t componentSize;
+    // Live rows
+    size_t usedBytes;
+    // Allocated rows, including the used ones
+    size_t reservedBytes;
+};
+
+struct ArchetypeMemoryStats
+{
+    size_t rows;
+    size_t capacity;
+    // One entry per pool column, the entity column included
+    std::vector<ColumnMemoryStats> columns;
+    // Entity ID -> Row table
+    size_t entityMapBytes;
+    // Forward, backward and shared edge vectors
+    size_t edgeBytes;
+    // Pool column table and component ID -> column remap
+    size_t columnTableBytes;
+    // Column bytes summed
+    size_t usedBytes;
+    size_t reservedBytes;
+};
+
+struct EntityManagerMemoryStats
+{
+    // Entity ID -> Archetype table
+    size_t archetypeLookupBytes;
+    // Entity ID -> Generation table
+    size_t generationLookupBytes;
+    // Free entity ID list
+    size_t recycledIdBytes;
+    size_t hierarchyBytes;
+    // Sparse sets of sparse components
+    size_t sparseStorageBytes;
+};
+
+struct SpaceMemoryStats
+{
+    std::vector<ArchetypeMemoryStats> archetypes;
+    EntityManagerMemoryStats entityManager;
+    // Column bytes of every archetype
+    size_t usedBytes;
+    // Every reserved byte reported above
+    size_t reservedBytes;
+};
+
+} // namespace X
+
+namespace X::Internal
+{
+
+template<typename T>
+[[nodiscard]] size_t GetReservedBytes(const std::vector<T>& container)
+{
+    return container.capacity() * sizeof(T);
+}
+
+template<typename T>
+[[nodiscard]] size_t GetReservedBytes(const std::deque<T>& container)
+{
+    return container.size() * sizeof(T);
+}
+
+} // namespace X::Internal
@@ -3,13 +3,18 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <cstddef>
 #include <iostream>
+#include <limits>
 #include <type_traits>
 #include <vector>
 
 #include "Alloy/AlloyConfig.h"
 #include "ComponentTypeTraits.h"
 #include "Entity.h"
+#include "LatencyHistogram.h"
+#include "MemoryStats.h"
+#include "QueryTerms.h"
 
 // TODO: @calin move entities to the end of the pool's vector list for perf?
 // TODO: @calin merge Pool.h and ChunkAllocator.h
@@ -22,44 +27,84 @@ class Pool
 {
 public:
 #if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
-    using DataType = std::vector<std::vector<uint8_t>>;
-    using ChunkAllocatorType = std::vector<DataType>;
+    // Columns are split into fixed size chunks, growing never moves existing rows
+    using DataType = uint8_t*;
+    using DataTypeNoPtr = uint8_t;
+    using ColumnDataType = std::vector<DataType>;
     static constexpr size_t StartCapacity = 0;
 #elif defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE)
     using DataType = uint8_t*;
     using DataTypeNoPtr = uint8_t;
-    using ChunkAllocatorType = std::vector<DataType>;
+    using ColumnDataType = DataType;
     static constexpr size_t StartCapacity = 8;
 #endif
     using IndexType = size_t;
+    using ColumnIndex = uint16_t;
+    static constexpr ColumnIndex NoColumn = std::numeric_limits<ColumnIndex>::max();
+
+    // Only the pool's own components have a column, their stride and functions are copied in from ComponentInfo
+    struct Column
+    {
+        ComponentTypeTraits::ComponentId componentId;
+        // Bytes per row
+        size_t stride;
+        ComponentTypeTraits::DestructorCaller destructorCaller;
+        bool trivialDestructor;
+        ComponentTypeTraits::TransferCaller transferCaller;
+        ColumnDataType data{};
+    };
+
+    // A column copied when an entity moves between two pools, see MapColumns
+    struct ColumnMove
+    {
+        ColumnIndex source;
+        ColumnIndex destination;
+        size_t stride;
+        ComponentTypeTraits::TransferCaller transferCaller;
+    };
 
-    Pool() : archetypeSize(sizeof(Entity)), capacity(StartCapacity), componentIds{ GetComponentId<Entity>::value }
+    Pool() : archetypeSize(sizeof(Entity)), capacity(StartCapacity)
     {
+        columns.emplace_back(MakeColumn(GetComponentId<Entity>::value));
         RawDataConstructHelper();
     }
 
+    // Allocates the columns and rebuilds the component ID -> column remap
     void RawDataConstructHelper()
     {
-        rawData = ChunkAllocatorType{ X::Internal::ComponentTypeTraits::CurrentCount() };
+        capacity = StartCapacity;
+        ComponentTypeTraits::ComponentId maxComponentId = 0;
+        for (const Column& column : columns)
+            maxComponentId = std::max(maxComponentId, column.componentId);
+        columnIndices.assign(maxComponentId + 1, NoColumn);
+        ALLOY_ASSERT(columns.size() < NoColumn, "Pool holds too many columns.");
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            columnIndices[columns[i].componentId] = static_cast<ColumnIndex>(i);
 #if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE)
-        // Using the "this" pointer because the parameter was moved
-        for (X::Internal::ComponentTypeTraits::ComponentId componentId : componentIds)
-            rawData[componentId] = new DataTypeNoPtr[StartCapacity * X::Internal::ComponentTypeTraits::GetComponentInfo()[componentId].size];
+            columns[i].data = new DataTypeNoPtr[StartCapacity * columns[i].stride];
 #endif
+        }
     }
 
     void RawDataDestructHelper()
     {
-        // @calin TODO: undo this change
         // Call component destructors
-        for (X::Internal::ComponentTypeTraits::ComponentId componentId : componentIds)
+        for (Column& column : columns)
         {
-            X::Internal::ComponentTypeTraits::ComponentInfo& componentInfo = X::Internal::ComponentTypeTraits::GetComponentInfo()[componentId];
-            DataType& componentIdVector = rawData[componentId];
-            for (int j = 0; j < size; ++j)
-                componentInfo.destructorCaller(&componentIdVector[componentInfo.size * j]);
-            delete[] rawData[componentId];
+            if (!column.trivialDestructor)
+                for (size_t j = 0; j < size; ++j)
+                    column.destructorCaller(GetColumnRow(column, j));
+#if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
+            for (DataType chunk : column.data)
+                delete[] chunk;
+            column.data.clear();
+#elif defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE)
+            delete[] column.data;
+            column.data = nullptr;
+#endif
         }
+        size = 0;
     }
 
     ~Pool()
@@ -72,46 +117,77 @@ public:
         // Grow, if needed
         if (size == capacity)
         {
-            for (X::Internal::ComponentTypeTraits::ComponentId componentId : componentIds)
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+            ScopedLatency growthLatency(StructuralOperation::PoolGrowth);
+#endif
+#if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
+            // Add a chunk to every column
+            for (Column& column : columns)
+                column.data.emplace_back(new DataTypeNoPtr[PoolRowsPerChunk * column.stride]);
+            capacity += PoolRowsPerChunk;
+#elif defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE)
+            for (Column& column : columns)
             {
-                X::Internal::ComponentTypeTraits::ComponentInfo& componentInfo = X::Internal::ComponentTypeTraits::GetComponentInfo()[componentId];
                 // Allocate double-sized buffer
-                auto newRawData = new DataTypeNoPtr[capacity * 2 * componentInfo.size];
+                auto newRawData = new DataTypeNoPtr[capacity * 2 * column.stride];
                 // Copy everything to the new buffer
-                for (int j = 0; j < size; ++j)
+                for (size_t j = 0; j < size; ++j)
                 {
-                    unsigned offset = j * componentInfo.size;
-                    componentInfo.transferCaller(rawData[componentId] + offset, newRawData + offset);
+                    const size_t offset = j * column.stride;
+                    column.transferCaller(column.data + offset, newRawData + offset);
                 }
-                delete[] rawData[componentId];
-                rawData[componentId] = newRawData;
+                delete[] column.data;
+                column.data = newRawData;
             }
             capacity *= 2;
+#endif
         }
 
-        X::Internal::ComponentTypeTraits::ComponentId entityComponentId = X::Internal::GetComponentId<X::Entity>::value;
-        *reinterpret_cast<X::Entity*>(&rawData[entityComponentId][sizeof(X::Entity) * size]) = indexParent;
+        *reinterpret_cast<X::Entity*>(GetColumnRow<X::Entity>(size)) = indexParent;
         return size++;
     }
 
     [[nodiscard]] Entity GetParent(const IndexType index) const
     {
-        return *reinterpret_cast<const Entity*>(Get(GetComponentId<Entity>::value, index));
+        ALLOY_ASSERT(size > index, "Allocator does not hold the given index.");
+        return *reinterpret_cast<const Entity*>(GetColumnRow<Entity>(index));
     }
 
-    void CopyComponentToPool(const IndexType index, const size_t componentId, uint8_t* component)
+    // Appends a move for every column, but the entity's, that both pools hold
+    static void MapColumns(const Pool& from, const Pool& to, std::vector<ColumnMove>& moves)
     {
-        // Not worth branching for a "speed copy"
-        ComponentTypeTraits::GetComponentInfo()[componentId].transferCaller(
-            component,
-            Get(componentId, index) //
-        );
+        for (size_t source = 1; source < from.columns.size(); ++source)
+        {
+            const Column& column = from.columns[source];
+            if (column.componentId < to.columnIndices.size() && to.columnIndices[column.componentId] != NoColumn)
+                moves.emplace_back(ColumnMove{ static_cast<ColumnIndex>(source), to.columnIndices[column.componentId], column.stride, column.transferCaller });
+        }
+    }
+
+    // Moves the mapped columns of another pool's row into a row of this pool
+    void MoveRow(const Pool& from, const ColumnMove* moves, const size_t moveCount, const IndexType fromIndex, const IndexType toIndex)
+    {
+        ALLOY_ASSERT(from.size > fromIndex, "Allocator does not hold the given index.");
+        ALLOY_ASSERT(size > toIndex, "Allocator does not hold the given index.");
+        for (size_t i = 0; i < moveCount; ++i)
+        {
+            const ColumnMove& move = moves[i];
+            move.transferCaller(
+                GetRow(from.columns[move.source].data, move.stride, fromIndex),
+                GetRow(columns[move.destination].data, move.stride, toIndex));
+        }
     }
 
     template<typename Component, typename... Args>
     Component& EmplaceComponent(const IndexType index, const size_t componentId, Args&&... args)
     {
-        if constexpr (std::is_aggregate_v<Component>)
+        if constexpr (IsTagComponent<Component>)
+        {
+            // Still construct the tag in case its constructor has side effects
+            (void) Component{ std::forward<Args>(args)... };
+            return GetTagInstance<Component>();
+        }
+        else if constexpr (std::is_aggregate_v<Component>)
         {
             // SSO (Small String Optimizations) cannot be trivially disabled and will cause strings to point to stack memory
             // which will only be valid until removed from the stack and thus should not be put into ECS.
@@ -128,7 +204,8 @@ public:
     template<typename Component>
     void InsertComponent(const IndexType index, const size_t componentId, const Component& component)
     {
-        *reinterpret_cast<Component*>(Get(componentId, index)) = component;
+        if constexpr (IsColumnComponent<Component>)
+            *reinterpret_cast<Component*>(Get(componentId, index)) = component;
     }
 
     template<bool Destroy>
@@ -138,13 +215,25 @@ public:
         if constexpr (Destroy)
         {
             // Call component destructors
-            for (X::Internal::ComponentTypeTraits::ComponentId componentId : componentIds)
-            {
-                X::Internal::ComponentTypeTraits::ComponentInfo& componentInfo = X::Internal::ComponentTypeTraits::GetComponentInfo()[componentId];
-                DataType& componentTypeVector = rawData[componentId];
-                componentInfo.destructorCaller(&componentTypeVector[componentInfo.size * size]);
-            }
+            for (const Column& column : columns)
+                column.destructorCaller(GetColumnRow(column, size));
+        }
+    }
+
+    // Destroys every row, one column at a time, the columns keep their capacity
+    // Columns of trivially destructible components are skipped
+    void Clear()
+    {
+        const size_t rows = size;
+        for (const Column& column : columns)
+        {
+            if (column.trivialDestructor)
+                continue;
+            for (size_t row = 0; row < rows; ++row)
+                column.destructorCaller(GetColumnRow(column, row));
+            ALLOY_ASSERT(size == rows, "Component destructors must not create or destroy entities while a pool is cleared.");
         }
+        size = 0;
     }
 
     [[nodiscard]] size_t GetSize() const
@@ -157,8 +246,29 @@ public:
         return capacity;
     }
 
-#ifdef ALLOY_DEBUG
+    // Fills in the row and column part of an archetype's memory statistics
+    void GetMemoryStats(ArchetypeMemoryStats& stats) const
+    {
+        stats.rows = size;
+        stats.capacity = capacity;
+        stats.usedBytes = 0;
+        stats.reservedBytes = 0;
+        for (const Column& column : columns)
+        {
+            stats.columns.emplace_back(ColumnMemoryStats{ column.componentId, column.stride, size * column.stride, capacity * column.stride });
+            stats.usedBytes += size * column.stride;
+            stats.reservedBytes += capacity * column.stride;
+        }
+        stats.columnTableBytes = GetReservedBytes(columns) + GetReservedBytes(columnIndices);
+#if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
+        for (const Column& column : columns)
+            stats.columnTableBytes += GetReservedBytes(column.data);
+#endif
+    }
 
+#if defined(ALLOY_DEBUG) || defined(ALLOY_INSTRUMENTATION)
+
+    // Bytes per row, the entity included
     [[nodiscard]] size_t GetArchetypeSize() const
     {
         return archetypeSize;
@@ -172,11 +282,17 @@ public:
     }
 
     template<typename Component>
-    [[nodiscard]] Component& GetComponent(const IndexType index)
+    [[nodiscard]] ComponentReference<Component> GetComponent(const IndexType index)
     {
-        return *reinterpret_cast<Component*>(
-            Get(GetComponentId<Component>::value, index) //
-        );
+        if constexpr (IsTagComponent<Component>)
+            return GetTagInstance<Component>();
+        else if constexpr (IsSharedComponent<Component>)
+            return *reinterpret_cast<const Component*>(GetSharedValue(GetComponentId<Component>::value));
+        else
+        {
+            ALLOY_ASSERT(size > index, "Allocator does not hold the given index.");
+            return *reinterpret_cast<Component*>(GetColumnRow<Component>(index));
+        }
     }
 
     // Moves the last component into the given index, returning the affected index's parent
@@ -184,119 +300,309 @@ public:
     unsigned int CopyLastIn(const IndexType index)
     {
         // Move the last objects in
-        for (ComponentTypeTraits::ComponentId componentId : componentIds)
+        ALLOY_ASSERT(size > index, "Allocator does not hold the given index.");
+        for (const Column& column : columns)
+            column.transferCaller(GetColumnRow(column, size - 1), GetColumnRow(column, index));
+        return GetParent(index);
+    }
+
+    // Reorders every column together so the row at order[i] ends up at row i
+    // Rows are moved cycle by cycle through a single scratch row, the given order is consumed in the process
+    void Permute(std::vector<IndexType>& order)
+    {
+        constexpr IndexType Placed = std::numeric_limits<IndexType>::max();
+        constexpr size_t Alignment = alignof(std::max_align_t);
+
+        // Lay out one aligned slot per component in the scratch row
+        std::vector<size_t> scratchOffsets{};
+        scratchOffsets.reserve(columns.size());
+        size_t scratchSize = 0;
+        for (const Column& column : columns)
         {
-            uint8_t* componentAtIndex = Get(componentId, index);
-            uint8_t* lastComponent = Get(componentId, size - 1);
-            ComponentTypeTraits::GetComponentInfo()[componentId].transferCaller(lastComponent, componentAtIndex);
+            scratchOffsets.emplace_back(scratchSize);
+            scratchSize += (column.stride + Alignment - 1) / Alignment * Alignment;
+        }
+        std::vector<std::max_align_t> scratch(scratchSize / Alignment);
+        uint8_t* scratchRow = reinterpret_cast<uint8_t*>(scratch.data());
+
+        for (IndexType start = 0; start < size; ++start)
+        {
+            if (order[start] == start || order[start] == Placed)
+                continue;
+
+            // Lift the first row of the cycle out, shift the rest of the cycle down, then drop it into the gap
+            for (size_t i = 0; i < columns.size(); ++i)
+                columns[i].transferCaller(GetColumnRow(columns[i], start), scratchRow + scratchOffsets[i]);
+
+            IndexType current = start;
+            while (true)
+            {
+                IndexType next = order[current];
+                order[current] = Placed;
+                if (next == start)
+                {
+                    for (size_t i = 0; i < columns.size(); ++i)
+                        columns[i].transferCaller(scratchRow + scratchOffsets[i], GetColumnRow(columns[i], current));
+                    break;
+                }
+                for (const Column& column : columns)
+                    column.transferCaller(GetColumnRow(column, next), GetColumnRow(column, current));
+                current = next;
+            }
         }
-        return GetParent(index);
     }
 
     template<typename Component>
     static void CreateIncreasedPool(const Pool* oldPool, Pool* newPool)
     {
-        // Increase the archetype size stored
-        newPool->archetypeSize = oldPool->archetypeSize + sizeof(Component);
-
-        // Copy the old component data
-        newPool->componentIds = oldPool->componentIds;
+        // Copy the old columns, without their data
+        newPool->RawDataDestructHelper();
+        newPool->archetypeSize = oldPool->archetypeSize;
+        newPool->CopyColumnLayout(*oldPool);
 
-        // Add a record for the new component data
-        newPool->componentIds.emplace_back(GetComponentId<Component>::value);
+        // Add a column for the new component, tags and shared components have none
+        if constexpr (IsColumnComponent<Component>)
+        {
+            newPool->archetypeSize += sizeof(Component);
+            newPool->columns.emplace_back(MakeColumn(GetComponentId<Component>::value));
+        }
 
-        // Create a new chunk allocator with the correct sizes
-        newPool->RawDataDestructHelper();
+        // Allocate the columns with the correct sizes
         newPool->RawDataConstructHelper();
     }
 
     template<typename Component>
     static void CreateDecreasedPool(const Pool* oldPool, Pool* newPool)
     {
-        // Decrease the archetype size stored
-        newPool->archetypeSize = oldPool->archetypeSize - sizeof(Component);
-
-        // Copy the old component data
-        newPool->componentIds = oldPool->componentIds;
-
-        // Remove size info about the component
-        auto& vec = newPool->componentIds;
-        // TODO: make this faster?
-        vec.erase(std::remove(vec.begin(), vec.end(), GetComponentId<Component>::value), vec.end());
-
-        // Create a new chunk allocator with the correct sizes
+        // Copy the old columns, without their data and minus the removed component's
         newPool->RawDataDestructHelper();
+        newPool->archetypeSize = oldPool->archetypeSize - (IsColumnComponent<Component> ? sizeof(Component) : 0);
+        newPool->CopyColumnLayout(*oldPool, GetComponentId<Component>::value);
+
+        // Allocate the columns with the correct sizes
         newPool->RawDataConstructHelper();
     }
 
-#if defined(ALLOY_DEBUG) || defined(ALLOY_EXPOSE_INTERNALS)
-
-    [[nodiscard]] const auto& GetComponentData() const
+    // Columns in order, the entity column first
+    [[nodiscard]] const std::vector<Column>& GetColumns() const
     {
-        return componentIds;
+        return columns;
     }
 
-#endif
-
-    template<typename... Components, size_t... Is, size_t N, typename UpdateFunction, typename... Args>
-    void UpdateHelper(size_t loops, std::index_sequence<Is...>,
-                      const std::array<DataType, N>& vectors,
-                      DataType entityVector,
+    // Without PassEntity the entity column is only read when a sparse term needs it to accept rows
+    // Visits the contiguous rows [firstRow, firstRow + loops)
+    template<bool PassEntity, typename... Terms, size_t... Is, size_t... As, typename UpdateFunction, typename... Args>
+    void UpdateHelper(size_t firstRow, size_t loops, std::index_sequence<Is...>, std::index_sequence<As...>,
+                      const std::array<DataType, sizeof...(Terms)>& externalData,
                       UpdateFunction&& updateFunction, Args&&... args)
     {
+        const std::array<DataType, sizeof...(Terms)> termData{ GetTermData<Terms>(externalData[Is], firstRow)... };
+        DataType entityVector = GetColumnRow<Entity>(firstRow);
         for (size_t i = 0; i < loops; ++i)
         {
+            Entity entity{};
+            if constexpr (PassEntity || HasSparseTerms<Terms...>)
+                entity = reinterpret_cast<Entity*>(entityVector)[i];
+            // Only sparse terms can reject a row
+            if constexpr (HasSparseTerms<Terms...>)
+                if (!(TermTraits<Terms>::Accept(termData[Is], entity) && ...))
+                    continue;
+
+            if constexpr (PassEntity)
+                updateFunction(
+                    entity,
+                    TermTraits<TermAt<As, Terms...>>::Fetch(termData[As], i, entity)...,
+                    std::forward<Args>(args)...);
+            else
+                updateFunction(
+                    TermTraits<TermAt<As, Terms...>>::Fetch(termData[As], i, entity)...,
+                    std::forward<Args>(args)...);
+        }
+    }
+
+    // Calls the update function for a single row that is known to be accepted by every term
+    template<bool PassEntity, typename... Terms, size_t... Is, size_t... As, typename UpdateFunction, typename... Args>
+    void UpdateRowHelper(const IndexType index, std::index_sequence<Is...>, std::index_sequence<As...>,
+                         const std::array<DataType, sizeof...(Terms)>& externalData,
+                         UpdateFunction&& updateFunction, Args&&... args)
+    {
+        // Term data points at the row itself
+        const std::array<DataType, sizeof...(Terms)> termData{ GetTermData<Terms>(externalData[Is], index)... };
+        const Entity entity = GetParent(index);
+        if constexpr (PassEntity)
             updateFunction(
-                reinterpret_cast<Entity*>(entityVector)[i],
-                (reinterpret_cast<Components*>(vectors[Is])[i])...,
+                entity,
+                TermTraits<TermAt<As, Terms...>>::Fetch(termData[As], 0, entity)...,
+                std::forward<Args>(args)...);
+        else
+            updateFunction(
+                TermTraits<TermAt<As, Terms...>>::Fetch(termData[As], 0, entity)...,
                 std::forward<Args>(args)...);
-        }
     }
 
-    template<typename... Components, typename UpdateFunction, typename... Args>
-    void Update(UpdateFunction&& updateFunction, Args&&... args)
+    template<bool PassEntity, typename... Terms, typename UpdateFunction, typename... Args>
+    void UpdateRow(const IndexType index, const std::array<DataType, sizeof...(Terms)>& externalData, UpdateFunction&& updateFunction, Args&&... args)
     {
-        UpdateHelper<Components...>(
-            size,
-            std::index_sequence_for<Components...>{},
-            std::array<DataType, sizeof...(Components)>{ rawData[GetComponentId<Components>::value]... },
-            rawData[GetComponentId<Entity>::value],
+        UpdateRowHelper<PassEntity, Terms...>(
+            index,
+            std::index_sequence_for<Terms...>{},
+            typename ArgumentIndices<Terms...>::Type{},
+            externalData,
             std::forward<UpdateFunction>(updateFunction),
             std::forward<Args>(args)...);
     }
 
-    std::vector<ComponentTypeTraits::ComponentId>& GetComponentIds()
+    // Calls the update function for every row, passing the entity and one argument per term
+    // Column terms are read from this pool, every other term from the given (per update) external data
+    // Extra arguments keep their value category through every run, like they do through every row
+    template<typename... Terms, typename UpdateFunction, typename... Args>
+    void Update(const std::array<DataType, sizeof...(Terms)>& externalData, UpdateFunction&& updateFunction, Args&&... args)
     {
-        return componentIds;
+        EachRun([&](const size_t firstRow, const size_t rows) {
+            UpdateHelper<true, Terms...>(
+                firstRow,
+                rows,
+                std::index_sequence_for<Terms...>{},
+                typename ArgumentIndices<Terms...>::Type{},
+                externalData,
+                updateFunction,
+                std::forward<Args>(args)...);
+        });
+    }
+
+    // Same as Update but the entity is not passed, so the entity column is left untouched
+    template<typename... Terms, typename UpdateFunction, typename... Args>
+    void Each(const std::array<DataType, sizeof...(Terms)>& externalData, UpdateFunction&& updateFunction, Args&&... args)
+    {
+        EachRun([&](const size_t firstRow, const size_t rows) {
+            UpdateHelper<false, Terms...>(
+                firstRow,
+                rows,
+                std::index_sequence_for<Terms...>{},
+                typename ArgumentIndices<Terms...>::Type{},
+                externalData,
+                updateFunction,
+                std::forward<Args>(args)...);
+        });
+    }
+
+    // Shared component values are owned by the space, the pool only points at them
+    void SetSharedValue(const ComponentTypeTraits::ComponentId componentId, uint8_t* value)
+    {
+        for (std::pair<ComponentTypeTraits::ComponentId, uint8_t*>& sharedValue : sharedValues)
+        {
+            if (sharedValue.first == componentId)
+            {
+                sharedValue.second = value;
+                return;
+            }
+        }
+        sharedValues.emplace_back(componentId, value);
+    }
+
+    [[nodiscard]] uint8_t* GetSharedValue(const ComponentTypeTraits::ComponentId componentId) const
+    {
+        for (const std::pair<ComponentTypeTraits::ComponentId, uint8_t*>& sharedValue : sharedValues)
+            if (sharedValue.first == componentId)
+                return sharedValue.second;
+        ALLOY_ASSERT(false, "Pool does not hold the given shared component.");
+        return nullptr;
     }
 
     // Returns a pointer to data with the size of dataSize
     [[nodiscard]] uint8_t* Get(const X::Internal::ComponentTypeTraits::ComponentId dataIndex, const size_t index)
     {
-        size_t componentSize = X::Internal::ComponentTypeTraits::GetComponentInfo()[dataIndex].size;
-        ALLOY_ASSERT(componentSize, "Allocator does not hold the given data index.");
         ALLOY_ASSERT(size > index, "Allocator does not hold the given index.");
-        return &rawData[dataIndex][index * componentSize];
+        return GetColumnRow(GetColumn(dataIndex), index);
     }
 
     // Returns a pointer to data with the size of dataSize
     [[nodiscard]] const uint8_t* Get(const X::Internal::ComponentTypeTraits::ComponentId dataIndex, const size_t index) const
     {
-        size_t componentSize = X::Internal::ComponentTypeTraits::GetComponentInfo()[dataIndex].size;
-        ALLOY_ASSERT(componentSize, "Allocator does not hold the given data index.");
         ALLOY_ASSERT(size > index, "Allocator does not hold the given index.");
-        return &rawData[dataIndex][index * componentSize];
+        return GetColumnRow(GetColumn(dataIndex), index);
     }
 
 private:
-    // Component IDs
-    std::vector<ComponentTypeTraits::ComponentId> componentIds;
+    [[nodiscard]] static Column MakeColumn(const ComponentTypeTraits::ComponentId componentId)
+    {
+        const ComponentTypeTraits::ComponentInfo& componentInfo = ComponentTypeTraits::GetComponentInfo()[componentId];
+        return Column{ componentId, componentInfo.size, componentInfo.destructorCaller, componentInfo.trivialDestructor, componentInfo.transferCaller };
+    }
+
+    // Copies another pool's columns without their data, skipping the given component's column
+    void CopyColumnLayout(const Pool& other, const ComponentTypeTraits::ComponentId skippedComponentId = std::numeric_limits<ComponentTypeTraits::ComponentId>::max())
+    {
+        columns.clear();
+        for (const Column& column : other.columns)
+            if (column.componentId != skippedComponentId)
+                columns.emplace_back(Column{ column.componentId, column.stride, column.destructorCaller, column.trivialDestructor, column.transferCaller });
+    }
+
+    [[nodiscard]] const Column& GetColumn(const ComponentTypeTraits::ComponentId componentId) const
+    {
+        ALLOY_ASSERT(componentId < columnIndices.size() && columnIndices[componentId] != NoColumn, "Allocator does not hold the given data index.");
+        return columns[columnIndices[componentId]];
+    }
+
+    // Returns a pointer to a row of column data, the rows after it are contiguous up to the end of its chunk
+    [[nodiscard]] static uint8_t* GetRow(const ColumnDataType& data, const size_t stride, const size_t row)
+    {
+#if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
+        return data[row >> PoolRowsPerChunkPower] + (row & (PoolRowsPerChunk - 1)) * stride;
+#elif defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE)
+        return data + row * stride;
+#endif
+    }
+
+    [[nodiscard]] static uint8_t* GetColumnRow(const Column& column, const size_t row)
+    {
+        return GetRow(column.data, column.stride, row);
+    }
+
+    // Same as above for a known component, its stride is a constant and the entity column needs no remap
+    template<typename Component>
+    [[nodiscard]] uint8_t* GetColumnRow(const size_t row) const
+    {
+        const Column& column = std::is_same_v<Component, Entity> ? columns.front() : GetColumn(GetComponentId<Component>::value);
+        return GetRow(column.data, ComponentSize<Component>, row);
+    }
+
+    // Calls the run function with (first row, row count) for every run of rows that is contiguous in every column
+    template<typename RunFunction>
+    void EachRun(RunFunction&& runFunction)
+    {
+#if defined(ALLOY_CHUNK_ALLOCATOR_MULTI_DEQUE_MODE)
+        for (size_t firstRow = 0; firstRow < size; firstRow += PoolRowsPerChunk)
+            runFunction(firstRow, std::min(PoolRowsPerChunk, size - firstRow));
+#elif defined(ALLOY_CHUNK_ALLOCATOR_MULTI_VECTOR_MODE)
+        if (size > 0)
+            runFunction(0, size);
+#endif
+    }
+
+    template<typename Term>
+    [[nodiscard]] DataType GetTermData(DataType externalData, const size_t row) const
+    {
+        if constexpr (TermTraits<Term>::Kind == TermKind::Column)
+            return GetColumnRow<typename TermTraits<Term>::ComponentType>(row);
+        else if constexpr (TermTraits<Term>::Kind == TermKind::Shared)
+            return GetSharedValue(GetComponentId<typename TermTraits<Term>::ComponentType>::value);
+        else
+            return externalData;
+    }
+
+    // One column per component held, the entity column first
+    std::vector<Column> columns{};
+    // Component ID -> Column index (or NoColumn), only as long as the largest component ID held
+    std::vector<ColumnIndex> columnIndices{};
     // Size of the archetype stored (includes entity ID)
     IndexType archetypeSize;
     // Component data
     size_t size{ 0 };
     size_t capacity{ 0 };
-    ChunkAllocatorType rawData{};
+    // Component ID -> Shared value, only a handful per pool
+    std::vector<std::pair<ComponentTypeTraits::ComponentId, uint8_t*>> sharedValues{};
 };
 
 } // namespace X::Internal
@@ -5,6 +5,7 @@
 #include "ComponentTypeTraits.h"
 #include "Containers/BitSet.h"
 #include "QueryInterface.h"
+#include "QueryTerms.h"
 
 #include <vector>
 
@@ -57,4 +58,17 @@ private:
     std::vector<std::vector<Archetype*>> spaceArchetypeMap;
 };
 
+template<typename List>
+struct QueryFromTypeList;
+
+template<typename... Components>
+struct QueryFromTypeList<TypeList<Components...>>
+{
+    using Type = Query<Components...>;
+};
+
+// Query matching the archetypes selected by a set of Update terms
+template<typename... Terms>
+using QueryFor = typename QueryFromTypeList<MaskTypesOf<Terms...>>::Type;
+
 } // namespace X::Internal
@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Archetype.h"
 #include "Containers/BitSet.h"
@@ -21,7 +23,13 @@ class QueryInterface
 public:
     explicit QueryInterface(BitSet bitMaskIn) : bitMask(std::move(bitMaskIn))
     {
+        const ::Internal::BitSetContainer& bitSetData = bitMask.GetRawData();
+        for (size_t i = 0; i < bitSetData.size(); ++i)
+            if (bitSetData[i] == BitSet::True)
+                componentIds.emplace_back(i);
+
         queries.emplace_back(this);
+        IndexQuery(this);
     }
 
     // No need to remove "this" from "queries" as it's all static time
@@ -40,26 +48,80 @@ public:
         return bitMask;
     }
 
+    // IDs of the components this query requires
+    [[nodiscard]] const std::vector<size_t>& GetComponentIds() const
+    {
+        return componentIds;
+    }
+
     [[nodiscard]] static const std::vector<QueryInterface*>& GetQueries()
     {
         return queries;
     }
 
+    // Calls the function with every query that could match the given component mask
+    // Each query is indexed under a single one of its components, so no query is visited twice
+    template<typename Function>
+    static void EachCandidateQuery(const BitSet& componentMask, Function&& function)
+    {
+        for (QueryInterface* query : unindexedQueries)
+            function(query);
+
+        const ::Internal::BitSetContainer& bitSetData = componentMask.GetRawData();
+        const size_t indexedCount = std::min(bitSetData.size(), componentQueries.size());
+        for (size_t componentId = 0; componentId < indexedCount; ++componentId)
+            if (bitSetData[componentId] != BitSet::False)
+                for (QueryInterface* query : componentQueries[componentId])
+                    function(query);
+    }
+
     // Does NOT check if the bitsets are equal but if all "TRUE" from component mask equal true on the other
     // The reverse of the previous statement might not be true!
     [[nodiscard]] bool DoesBitSetMatch(const BitSet& other) const
     {
-        ::Internal::BitSetContainer bitSetData = bitMask.GetRawData();
-        for (int i = 0; i < bitSetData.size(); ++i)
-            if (bitSetData[i] == BitSet::True && other[i] == BitSet::False)
+        for (size_t componentId : componentIds)
+            if (other[componentId] == BitSet::False)
                 return false;
         return true;
     }
 
 protected:
     BitSet bitMask;
+    std::vector<size_t> componentIds{};
 
     inline static std::vector<QueryInterface*> queries;
+
+private:
+    // Indexes the query under its component with the fewest indexed queries
+    static void IndexQuery(QueryInterface* query)
+    {
+        if (query->componentIds.empty())
+        {
+            unindexedQueries.emplace_back(query);
+            return;
+        }
+
+        size_t indexId = query->componentIds.front();
+        for (size_t componentId : query->componentIds)
+        {
+            if (componentId >= componentQueries.size())
+            {
+                indexId = componentId;
+                break;
+            }
+            if (componentQueries[componentId].size() < componentQueries[indexId].size())
+                indexId = componentId;
+        }
+
+        if (indexId >= componentQueries.size())
+            componentQueries.resize(indexId + 1);
+        componentQueries[indexId].emplace_back(query);
+    }
+
+    // Component ID -> Queries indexed under it
+    inline static std::vector<std::vector<QueryInterface*>> componentQueries;
+    // Queries without components, matching every archetype
+    inline static std::vector<QueryInterface*> unindexedQueries;
 };
 } // namespace X::Internal
 #endif
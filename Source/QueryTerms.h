@@ -0,0 +1,293 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ComponentTypeTraits.h"
+#include "Containers/BitSet.h"
+#include "Entity.h"
+#include "SparseStorage.h"
+
+namespace X
+{
+
+// Update term requesting a space resource (see Space::EmplaceResource)
+// Passed to the update function by reference, fetched once per update instead of once per row
+template<typename Type>
+struct Resource
+{
+};
+
+// Update term requiring a component without passing it to the update function
+// Prefer this for tags, they have no storage to pass
+template<typename Component>
+struct With
+{
+};
+
+} // namespace X
+
+namespace X::Internal
+{
+
+template<typename... Types>
+struct TypeList
+{
+};
+
+template<typename... Lists>
+struct TypeListConcat;
+
+template<>
+struct TypeListConcat<>
+{
+    using Type = TypeList<>;
+};
+
+template<typename... Types>
+struct TypeListConcat<TypeList<Types...>>
+{
+    using Type = TypeList<Types...>;
+};
+
+template<typename... First, typename... Second, typename... Rest>
+struct TypeListConcat<TypeList<First...>, TypeList<Second...>, Rest...>
+{
+    using Type = typename TypeListConcat<TypeList<First..., Second...>, Rest...>::Type;
+};
+
+enum class TermKind
+{
+    // Read from an archetype's pool, one value per row
+    Column,
+    // Has no storage, every row shares one instance
+    Tag,
+    // Read from a space's sparse set, rows without the component are skipped
+    Sparse,
+    // Read from the archetype, one value per archetype
+    Shared,
+    // Only selects archetypes, nothing is passed
+    Filter,
+    // Read from the space, one value per update
+    Resource
+};
+
+template<typename Component>
+struct ColumnTermTraits
+{
+    static constexpr TermKind Kind = TermKind::Column;
+    static constexpr bool HasArgument = true;
+    // Components an archetype must hold to match the term
+    using MaskTypes = TypeList<Component>;
+    using ComponentType = Component;
+
+    [[nodiscard]] static bool Accept(uint8_t*, const Entity)
+    {
+        return true;
+    }
+
+    [[nodiscard]] static Component& Fetch(uint8_t* data, const size_t row, const Entity)
+    {
+        return reinterpret_cast<Component*>(data)[row];
+    }
+};
+
+template<typename Component>
+struct TagTermTraits
+{
+    static constexpr TermKind Kind = TermKind::Tag;
+    static constexpr bool HasArgument = true;
+    using MaskTypes = TypeList<Component>;
+    using ComponentType = Component;
+
+    [[nodiscard]] static bool Accept(uint8_t*, const Entity)
+    {
+        return true;
+    }
+
+    [[nodiscard]] static Component& Fetch(uint8_t*, const size_t, const Entity)
+    {
+        return GetTagInstance<Component>();
+    }
+};
+
+// Passed read-only, data is the archetype's shared value
+template<typename Component>
+struct SharedTermTraits
+{
+    static constexpr TermKind Kind = TermKind::Shared;
+    static constexpr bool HasArgument = true;
+    using MaskTypes = TypeList<Component>;
+    using ComponentType = Component;
+
+    [[nodiscard]] static bool Accept(uint8_t*, const Entity)
+    {
+        return true;
+    }
+
+    [[nodiscard]] static const Component& Fetch(uint8_t* data, const size_t, const Entity)
+    {
+        return *reinterpret_cast<const Component*>(data);
+    }
+};
+
+// Joined by entity against the space's sparse set, data is the sparse set
+template<typename Component>
+struct SparseTermTraits
+{
+    static constexpr TermKind Kind = TermKind::Sparse;
+    static constexpr bool HasArgument = true;
+    using MaskTypes = TypeList<>;
+    using ComponentType = Component;
+
+    [[nodiscard]] static bool Accept(uint8_t* data, const Entity entity)
+    {
+        return reinterpret_cast<SparseSet<Component>*>(data)->Contains(entity);
+    }
+
+    [[nodiscard]] static Component& Fetch(uint8_t* data, const size_t, const Entity entity)
+    {
+        return reinterpret_cast<SparseSet<Component>*>(data)->Get(entity);
+    }
+};
+
+// Describes how an Update template parameter (term) selects archetypes and what it passes to the update function
+// Data is the pointer resolved for the term: a column's first row, a shared value, a sparse set, or a resource
+// Rows are skipped unless every term accepts the row's entity
+template<typename Term>
+struct TermTraits : std::conditional_t<
+                        IsSparseComponent<Term>,
+                        SparseTermTraits<Term>,
+                        std::conditional_t<
+                            IsSharedComponent<Term>,
+                            SharedTermTraits<Term>,
+                            std::conditional_t<IsTagComponent<Term>, TagTermTraits<Term>, ColumnTermTraits<Term>>>>
+{
+};
+
+// Read-only terms select the same archetypes but pass const references
+template<typename Term>
+struct TermTraits<const Term> : TermTraits<Term>
+{
+    [[nodiscard]] static const auto& Fetch(uint8_t* data, const size_t row, const Entity entity)
+    {
+        return TermTraits<Term>::Fetch(data, row, entity);
+    }
+};
+
+// Filters on sparse components still join against the sparse set
+template<typename Component>
+struct TermTraits<With<Component>>
+{
+    static constexpr TermKind Kind = IsSparseComponent<Component> ? TermKind::Sparse : TermKind::Filter;
+    static constexpr bool HasArgument = false;
+    using MaskTypes = std::conditional_t<IsSparseComponent<Component>, TypeList<>, TypeList<Component>>;
+    using ComponentType = Component;
+
+    [[nodiscard]] static bool Accept(uint8_t* data, const Entity entity)
+    {
+        if constexpr (IsSparseComponent<Component>)
+            return reinterpret_cast<SparseSet<Component>*>(data)->Contains(entity);
+        else
+            return true;
+    }
+};
+
+// Resource<const Type> passes the resource as a const reference
+template<typename Type>
+struct TermTraits<Resource<Type>>
+{
+    static constexpr TermKind Kind = TermKind::Resource;
+    static constexpr bool HasArgument = true;
+    using MaskTypes = TypeList<>;
+    using ResourceType = std::remove_const_t<Type>;
+
+    [[nodiscard]] static bool Accept(uint8_t*, const Entity)
+    {
+        return true;
+    }
+
+    [[nodiscard]] static Type& Fetch(uint8_t* data, const size_t, const Entity)
+    {
+        return *reinterpret_cast<Type*>(data);
+    }
+};
+
+// Indices of the terms that pass an argument to the update function
+template<typename... Terms>
+struct ArgumentIndices
+{
+    static constexpr size_t Count = (static_cast<size_t>(TermTraits<Terms>::HasArgument) + ... + 0);
+
+    [[nodiscard]] static constexpr std::array<size_t, Count> Get()
+    {
+        std::array<size_t, Count> indices{};
+        size_t argument = 0;
+        size_t term = 0;
+        ((TermTraits<Terms>::HasArgument ? (indices[argument++] = term++) : term++), ...);
+        return indices;
+    }
+
+    template<size_t... Is>
+    [[nodiscard]] static constexpr auto Make(std::index_sequence<Is...>)
+    {
+        return std::index_sequence<Get()[Is]...>{};
+    }
+
+    using Type = decltype(Make(std::make_index_sequence<Count>{}));
+};
+
+// Components an archetype must hold to match every given term
+template<typename... Terms>
+using MaskTypesOf = typename TypeListConcat<typename TermTraits<Terms>::MaskTypes...>::Type;
+
+template<typename... Components>
+[[nodiscard]] bool HasAllComponents(TypeList<Components...>, const BitSet& componentMask)
+{
+    return ((componentMask[GetComponentId<Components>::value] != BitSet::False) && ...);
+}
+
+template<typename... Terms>
+inline constexpr bool HasSparseTerms = ((TermTraits<Terms>::Kind == TermKind::Sparse) || ...);
+
+template<size_t Index, typename... Terms>
+using TermAt = std::tuple_element_t<Index, std::tuple<Terms...>>;
+
+// Terms named by an update function's parameters, an optional leading X::Entity followed by components
+template<typename... Parameters>
+struct EachParameters
+{
+    static constexpr bool PassEntity = false;
+    using Terms = TypeList<>;
+};
+
+template<typename First, typename... Rest>
+struct EachParameters<First, Rest...>
+{
+    static constexpr bool PassEntity = std::is_same_v<std::decay_t<First>, Entity>;
+    using Terms = std::conditional_t<
+        PassEntity,
+        TypeList<std::remove_reference_t<Rest>...>,
+        TypeList<std::remove_reference_t<First>, std::remove_reference_t<Rest>...>>;
+};
+
+// Only non-generic lambdas and function objects have a single signature to deduce from
+template<typename Function>
+struct EachSignature : EachSignature<decltype(&Function::operator())>
+{
+};
+
+template<typename Class, typename Return, typename... Parameters>
+struct EachSignature<Return (Class::*)(Parameters...) const> : EachParameters<Parameters...>
+{
+};
+
+template<typename Class, typename Return, typename... Parameters>
+struct EachSignature<Return (Class::*)(Parameters...)> : EachParameters<Parameters...>
+{
+};
+
+} // namespace X::Internal
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Alloy/AlloyConfig.h"
+
+namespace X::Internal
+{
+
+struct ResourceTypeTraits
+{
+    using ResourceId = size_t;
+
+    static ResourceId& CurrentCount()
+    {
+        static ResourceId currentId = 0;
+        return currentId;
+    }
+
+    template<typename Resource>
+    static ResourceId RegisterResource()
+    {
+        return CurrentCount()++;
+    }
+};
+
+template<typename Resource>
+struct GetResourceId
+{
+    const static ResourceTypeTraits::ResourceId value;
+};
+
+template<typename Resource>
+const ResourceTypeTraits::ResourceId GetResourceId<Resource>::value = ResourceTypeTraits::RegisterResource<Resource>();
+
+// Typed, per-space, singletons living outside of archetypes
+// Resource ID -> Resource, so every access is a single indexed load
+// A removed resource's memory is kept, emplacing the same type again reuses it
+class ResourceStorage
+{
+public:
+    ResourceStorage() = default;
+
+    ResourceStorage(const ResourceStorage&) = delete;
+    ResourceStorage& operator=(const ResourceStorage&) = delete;
+
+    ~ResourceStorage()
+    {
+        Clear();
+        for (ResourceSlot& slot : resources)
+            if (slot.data != nullptr)
+                slot.deallocator(slot.data);
+    }
+
+    // Constructs a resource, replacing any existing one of the same type
+    template<typename Resource, typename... Args>
+    Resource& Emplace(Args&&... args)
+    {
+        const ResourceTypeTraits::ResourceId resourceId = GetResourceId<Resource>::value;
+        if (resourceId >= resources.size())
+            resources.resize(resourceId + 1);
+
+        ResourceSlot& slot = resources[resourceId];
+        if (slot.alive)
+            slot.destructorCaller(slot.data);
+        else if (slot.data == nullptr)
+        {
+            slot.data = std::allocator<Resource>{}.allocate(1);
+            slot.destructorCaller = +[](void* data) {
+                std::destroy_at(static_cast<Resource*>(data));
+            };
+            slot.deallocator = +[](void* data) {
+                std::allocator<Resource>{}.deallocate(static_cast<Resource*>(data), 1);
+            };
+        }
+        slot.alive = false;
+
+        Resource* resource;
+        if constexpr (std::is_aggregate_v<Resource>)
+            resource = new (slot.data) Resource{ std::forward<Args>(args)... };
+        else
+            resource = new (slot.data) Resource(std::forward<Args>(args)...);
+        slot.alive = true;
+        return *resource;
+    }
+
+    template<typename Resource>
+    void Remove()
+    {
+        ALLOY_ASSERT(Has<Resource>(), "Space does not hold the resource that is being removed.");
+        ResourceSlot& slot = resources[GetResourceId<Resource>::value];
+        slot.destructorCaller(slot.data);
+        slot.alive = false;
+    }
+
+    // Removes every resource, keeping their memory
+    void Clear()
+    {
+        for (ResourceSlot& slot : resources)
+        {
+            if (slot.alive)
+                slot.destructorCaller(slot.data);
+            slot.alive = false;
+        }
+    }
+
+    template<typename Resource>
+    [[nodiscard]] bool Has() const
+    {
+        const ResourceTypeTraits::ResourceId resourceId = GetResourceId<Resource>::value;
+        return resourceId < resources.size() && resources[resourceId].alive;
+    }
+
+    template<typename Resource>
+    [[nodiscard]] Resource& Get()
+    {
+        ALLOY_ASSERT(Has<Resource>(), "Space does not hold the requested resource.");
+        return *static_cast<Resource*>(resources[GetResourceId<Resource>::value].data);
+    }
+
+private:
+    struct ResourceSlot
+    {
+        // Allocated on the first emplace, freed with the storage
+        void* data{ nullptr };
+        bool alive{ false };
+        void (*destructorCaller)(void* data){ nullptr };
+        void (*deallocator)(void* data){ nullptr };
+    };
+
+    std::vector<ResourceSlot> resources{};
+};
+
+} // namespace X::Internal
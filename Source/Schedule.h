@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Alloy/AlloyConfig.h"
+#include "ComponentTypeTraits.h"
+#include "QueryTerms.h"
+#include "ResourceStorage.h"
+#include "Space.h"
+
+namespace X::Internal
+{
+
+// Components and resources a system reads and writes
+struct SystemAccess
+{
+    std::vector<ComponentTypeTraits::ComponentId> reads{};
+    std::vector<ComponentTypeTraits::ComponentId> writes{};
+    std::vector<ResourceTypeTraits::ResourceId> resourceReads{};
+    std::vector<ResourceTypeTraits::ResourceId> resourceWrites{};
+
+    // Two systems conflict if either writes something the other accesses
+    [[nodiscard]] bool ConflictsWith(const SystemAccess& other) const
+    {
+        return Intersects(writes, other.reads) || Intersects(writes, other.writes) || Intersects(reads, other.writes) ||
+               Intersects(resourceWrites, other.resourceReads) || Intersects(resourceWrites, other.resourceWrites) ||
+               Intersects(resourceReads, other.resourceWrites);
+    }
+
+private:
+    template<typename Id>
+    [[nodiscard]] static bool Intersects(const std::vector<Id>& a, const std::vector<Id>& b)
+    {
+        for (Id id : a)
+            if (std::find(b.begin(), b.end(), id) != b.end())
+                return true;
+        return false;
+    }
+};
+
+// Records the access of a single Update term, const terms are reads
+// Tags and filters only select archetypes, so they access nothing
+template<typename Term>
+struct TermAccess
+{
+    static void Record(SystemAccess& access)
+    {
+        using Traits = TermTraits<std::remove_const_t<Term>>;
+        if constexpr (Traits::Kind == TermKind::Column || Traits::Kind == TermKind::Sparse)
+        {
+            if constexpr (std::is_const_v<Term>)
+                access.reads.emplace_back(GetComponentId<typename Traits::ComponentType>::value);
+            else
+                access.writes.emplace_back(GetComponentId<typename Traits::ComponentType>::value);
+        }
+        else if constexpr (Traits::Kind == TermKind::Shared)
+        {
+            access.reads.emplace_back(GetComponentId<typename Traits::ComponentType>::value);
+        }
+    }
+};
+
+template<typename Type>
+struct TermAccess<Resource<Type>>
+{
+    static void Record(SystemAccess& access)
+    {
+        if constexpr (std::is_const_v<Type>)
+            access.resourceReads.emplace_back(GetResourceId<std::remove_const_t<Type>>::value);
+        else
+            access.resourceWrites.emplace_back(GetResourceId<Type>::value);
+    }
+};
+
+} // namespace X::Internal
+
+namespace X
+{
+
+// Runs a set of Update systems on a space, overlapping systems whose component and resource access does not conflict
+// Systems are ordered by a dependency graph built from their declared access:
+// a system waits on every earlier system that writes what it accesses or accesses what it writes
+// so every component and resource sees the same sequence of systems as running them in the order they were added
+// Systems must not add or remove components, or create or destroy entities, while the schedule runs
+class Schedule
+{
+public:
+    // Zero worker threads runs every system on the calling thread
+    explicit Schedule(size_t workerCount = std::max(std::thread::hardware_concurrency(), 1u) - 1)
+    {
+        workers.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i)
+            workers.emplace_back([this]() {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    condition.wait(lock, [this]() {
+                        return stopping || !ready.empty();
+                    });
+                    if (stopping)
+                        return;
+                    RunReadySystem(lock);
+                }
+            });
+    }
+
+    Schedule(const Schedule&) = delete;
+    Schedule& operator=(const Schedule&) = delete;
+
+    ~Schedule()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    // Adds a system running Space::Update<Terms...> with the given function
+    // Const terms (const Position, X::Resource<const Clock>) declare read-only access
+    template<typename... Terms, typename UpdateFunction>
+    void Add(UpdateFunction&& updateFunction)
+    {
+        System system{};
+        (Internal::TermAccess<Terms>::Record(system.access), ...);
+        system.prepare = [](Space& space) {
+            space.PrepareUpdate<Terms...>();
+        };
+        system.run = [updateFunction = std::forward<UpdateFunction>(updateFunction)](Space& space) mutable {
+            space.Update<Terms...>(updateFunction);
+        };
+
+        const size_t index = systems.size();
+        for (size_t earlier = 0; earlier < index; ++earlier)
+        {
+            if (systems[earlier].access.ConflictsWith(system.access))
+            {
+                systems[earlier].dependents.emplace_back(index);
+                ++system.dependencyCount;
+            }
+        }
+        systems.emplace_back(std::move(system));
+    }
+
+    // Runs every system once on the given space, returning when all have finished
+    void Run(Space& space)
+    {
+        if (systems.empty())
+            return;
+
+        // Build any lazily created storage up front so that the systems themselves never modify the space
+        for (System& system : systems)
+            system.prepare(space);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        currentSpace = &space;
+        pending = systems.size();
+        for (size_t index = 0; index < systems.size(); ++index)
+        {
+            systems[index].remainingDependencies = systems[index].dependencyCount;
+            if (systems[index].dependencyCount == 0)
+                ready.emplace_back(index);
+        }
+        condition.notify_all();
+
+        // The calling thread works alongside the workers
+        while (pending > 0)
+        {
+            if (ready.empty())
+                condition.wait(lock);
+            else
+                RunReadySystem(lock);
+        }
+        currentSpace = nullptr;
+    }
+
+    [[nodiscard]] size_t GetSystemCount() const
+    {
+        return systems.size();
+    }
+
+    [[nodiscard]] size_t GetWorkerCount() const
+    {
+        return workers.size();
+    }
+
+private:
+    struct System
+    {
+        Internal::SystemAccess access{};
+        std::function<void(Space&)> prepare{};
+        std::function<void(Space&)> run{};
+        // Later systems that must wait for this one
+        std::vector<size_t> dependents{};
+        size_t dependencyCount{ 0 };
+        size_t remainingDependencies{ 0 };
+    };
+
+    // Must be called with the lock held and a ready system queued
+    void RunReadySystem(std::unique_lock<std::mutex>& lock)
+    {
+        const size_t index = ready.front();
+        ready.pop_front();
+
+        lock.unlock();
+        systems[index].run(*currentSpace);
+        lock.lock();
+
+        for (size_t dependent : systems[index].dependents)
+            if (--systems[dependent].remainingDependencies == 0)
+                ready.emplace_back(dependent);
+        --pending;
+        condition.notify_all();
+    }
+
+    std::vector<System> systems{};
+    std::vector<std::thread> workers{};
+    std::mutex mutex{};
+    std::condition_variable condition{};
+    // Indices of systems whose dependencies have all finished
+    std::deque<size_t> ready{};
+    size_t pending{ 0 };
+    Space* currentSpace{ nullptr };
+    bool stopping{ false };
+};
+
+} // namespace X
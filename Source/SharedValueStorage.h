@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Alloy/AlloyConfig.h"
+#include "ComponentTypeTraits.h"
+
+namespace X::Internal
+{
+
+class SharedValueTableInterface
+{
+public:
+    virtual ~SharedValueTableInterface() = default;
+
+    [[nodiscard]] virtual uint8_t* GetRaw(size_t valueId) = 0;
+};
+
+// Interned values of a single shared component type
+// Equal values share one ID (and one instance), values live as long as the space
+template<typename Component>
+class SharedValueTable final : public SharedValueTableInterface
+{
+public:
+    // Returns the ID of an equal value, adding the value if none exists
+    size_t Intern(Component&& value)
+    {
+        for (size_t valueId = 0; valueId < values.size(); ++valueId)
+            if (*values[valueId] == value)
+                return valueId;
+        values.emplace_back(std::make_unique<Component>(std::move(value)));
+        return values.size() - 1;
+    }
+
+    [[nodiscard]] uint8_t* GetRaw(const size_t valueId) final
+    {
+        return reinterpret_cast<uint8_t*>(values[valueId].get());
+    }
+
+private:
+    // Value ID -> Value, individually allocated so pools can point at them
+    std::vector<std::unique_ptr<Component>> values{};
+};
+
+// Component ID -> Shared value table, for every shared component used in a space
+class SharedValueStorage
+{
+public:
+    template<typename Component>
+    [[nodiscard]] SharedValueTable<Component>& Get()
+    {
+        const ComponentTypeTraits::ComponentId componentId = GetComponentId<Component>::value;
+        if (componentId >= tables.size())
+            tables.resize(componentId + 1);
+
+        std::unique_ptr<SharedValueTableInterface>& table = tables[componentId];
+        if (table == nullptr)
+        {
+            table = std::make_unique<SharedValueTable<Component>>();
+            componentIds.emplace_back(componentId);
+        }
+        return static_cast<SharedValueTable<Component>&>(*table);
+    }
+
+    [[nodiscard]] SharedValueTableInterface& Get(const ComponentTypeTraits::ComponentId componentId)
+    {
+        return *tables[componentId];
+    }
+
+    // Shared components with a table
+    [[nodiscard]] const std::vector<ComponentTypeTraits::ComponentId>& GetComponentIds() const
+    {
+        return componentIds;
+    }
+
+private:
+    std::vector<std::unique_ptr<SharedValueTableInterface>> tables{};
+    std::vector<ComponentTypeTraits::ComponentId> componentIds{};
+};
+
+} // namespace X::Internal
@@ -4,7 +4,9 @@
 #include "Containers/RecycledCounter.h"
 #include "Entity.h"
 #include "EntityManager.h"
+#include "Instrumentation.h"
 #include "Query.h"
+#include "ResourceStorage.h"
 
 namespace X
 {
@@ -16,17 +18,37 @@ public:
         spaces.emplace_back(this);
     }
 
+    // Destroys every entity one by one, component destructors may destroy other entities
     void DestroyAllEntities()
     {
         for (Archetype* archetype : Internal::Query<>::Get()->GetArchetypes(spaceId))
         {
             X::Internal::Pool& pool = archetype->GetPool();
             // Using a 'while' here because an entity's destructor can destroy another entity
+            // Destroying the last row never moves another row into its place
             while (pool.GetSize() > 0)
-                entityManager.DestroyEntity<true>(pool.GetParent(0));
+                entityManager.DestroyEntity<true>(pool.GetParent(pool.GetSize() - 1));
         }
     }
 
+    // Destroys every entity at once, keeping the allocated storage for reuse
+    // Component destructors must not create or destroy entities
+    void Clear()
+    {
+#ifdef ALLOY_DEFER_DESTRUCTION
+        toDestroy.clear();
+#endif
+        entityManager.Clear();
+    }
+
+    // Destroys every entity and resource, for reusing the space in place of a new one
+    // Archetypes, their storage, resource memory and query registrations are kept, so refilling the space like before does not allocate
+    void Reset()
+    {
+        Clear();
+        resources.Clear();
+    }
+
     ~Space()
     {
         DestroyAllEntities();
@@ -123,7 +145,7 @@ public:
     // Returns a given component type from a given entity
     // Reference is only valid until the parent space is edited in ANY way
     template<typename Component>
-    Component& GetComponentTemporary(const Entity entity)
+    Internal::ComponentReference<Component> GetComponentTemporary(const Entity entity)
     {
         ALLOY_ASSERT(IsValid(entity), "Given entity is not valid.");
         ALLOY_ASSERT(HasComponent<Component>(entity), "Entity does not have the requested component.");
@@ -149,18 +171,259 @@ public:
         return entityManager.IsValid(entity);
     }
 
+    // Calls function(entity, components...) for every entity in a list, like a GetComponents per entity
+    // Entities are visited in list order, with the lookups and components of upcoming entities prefetched ahead of use
+    // Every entity must be valid and hold every component, duplicates are visited once per occurrence
+    // The function must not add or remove components, or create or destroy entities
+    template<typename... Components, typename Function>
+    void Gather(const std::vector<Entity>& entities, Function&& function)
+    {
+        entityManager.Gather<Components...>(entities, [&function](size_t, const Entity entity, auto&... components) {
+            function(entity, components...);
+        });
+    }
+
+    // Same as Gather, writing the function's return value for each entity at the entity's position in the list
+    template<typename... Components, typename Result, typename Function>
+    void Gather(const std::vector<Entity>& entities, std::vector<Result>& results, Function&& function)
+    {
+        results.resize(entities.size());
+        entityManager.Gather<Components...>(entities, [&results, &function](size_t index, const Entity entity, auto&... components) {
+            results[index] = function(entity, components...);
+        });
+    }
+
+    // Changes whenever component rows may have moved, or their storage been reallocated
+    // Component pointers fetched at the same version are still valid
+    [[nodiscard]] uint64_t GetStructuralVersion() const
+    {
+        return entityManager.GetStructuralVersion();
+    }
+
     // Update a component system from a given type given an update function and arguments
-    template<typename... Components, typename UpdateFunction, typename... Args>
+    // Terms may also request resources, X::Resource<Type>, which are passed in place
+    template<typename... Terms, typename UpdateFunction, typename... Args>
     void Update(UpdateFunction&& updateFunction, Args&&... args)
     {
-        //        PRO_CATEGORY("Space::Update", Profiler::Category::Scene);
+        UpdateTerms<true, Terms...>(std::forward<UpdateFunction>(updateFunction), std::forward<Args>(args)...);
+    }
+
+    // Update with the terms deduced from the function's parameters, Each([](Position& position, const Velocity& velocity) {})
+    // Const parameters become read-only terms and the entity is only passed if the first parameter is an X::Entity
+    // Only the columns named by the function are read
+    template<typename UpdateFunction>
+    void Each(UpdateFunction&& updateFunction)
+    {
+        using Signature = Internal::EachSignature<std::decay_t<UpdateFunction>>;
+        EachHelper<Signature::PassEntity>(typename Signature::Terms{}, std::forward<UpdateFunction>(updateFunction));
+    }
+
+    // Creates the query and any lazily built storage an Update over the given terms touches
+    // Afterwards that Update only reads the space's structure, so it may run alongside other updates
+    template<typename... Terms>
+    void PrepareUpdate()
+    {
+        (void) Internal::QueryFor<Terms...>::Get();
+        ((void) GetExternalTermData<Terms>(), ...);
+    }
+
+    // Memory held by the space's archetypes and entity tables
+    [[nodiscard]] SpaceMemoryStats GetMemoryStats()
+    {
+        SpaceMemoryStats stats{};
+        stats.entityManager = entityManager.GetMemoryStats();
+        stats.reservedBytes = stats.entityManager.archetypeLookupBytes +
+                              stats.entityManager.generationLookupBytes +
+                              stats.entityManager.recycledIdBytes +
+                              stats.entityManager.hierarchyBytes +
+                              stats.entityManager.sparseStorageBytes;
+        for (Archetype* archetype : Internal::Query<>::Get()->GetArchetypes(spaceId))
+        {
+            ArchetypeMemoryStats& archetypeStats = stats.archetypes.emplace_back(archetype->GetMemoryStats());
+            stats.usedBytes += archetypeStats.usedBytes;
+            stats.reservedBytes += archetypeStats.reservedBytes + archetypeStats.entityMapBytes + archetypeStats.edgeBytes + archetypeStats.columnTableBytes;
+        }
+        return stats;
+    }
+
+#ifdef ALLOY_INSTRUMENTATION
+    // Every archetype graph edge entities have moved along, with how often and how many bytes were copied
+    [[nodiscard]] std::vector<ArchetypeTransitionStats> GetTransitionStats()
+    {
+        std::vector<ArchetypeTransitionStats> transitions{};
+        for (Archetype* archetype : Internal::Query<>::Get()->GetArchetypes(spaceId))
+        {
+            const std::vector<Archetype::EdgeTransitions>& forwardTransitions = archetype->GetForwardTransitions();
+            for (size_t componentId = 0; componentId < forwardTransitions.size(); ++componentId)
+                if (forwardTransitions[componentId].moves > 0)
+                    transitions.emplace_back(ArchetypeTransitionStats{
+                        archetype,
+                        archetype->GetForwardArchetypes()[componentId],
+                        componentId,
+                        true,
+                        forwardTransitions[componentId].moves,
+                        forwardTransitions[componentId].bytes });
+
+            const std::vector<Archetype::EdgeTransitions>& backwardTransitions = archetype->GetBackwardTransitions();
+            for (size_t componentId = 0; componentId < backwardTransitions.size(); ++componentId)
+                if (backwardTransitions[componentId].moves > 0)
+                    transitions.emplace_back(ArchetypeTransitionStats{
+                        archetype,
+                        archetype->GetBackwardArchetypes()[componentId],
+                        componentId,
+                        false,
+                        backwardTransitions[componentId].moves,
+                        backwardTransitions[componentId].bytes });
+
+            for (const Archetype::SharedEdge& sharedEdge : archetype->GetSharedForwardArchetypes())
+                if (sharedEdge.moves > 0)
+                    transitions.emplace_back(ArchetypeTransitionStats{
+                        archetype,
+                        sharedEdge.archetype,
+                        sharedEdge.componentId,
+                        true,
+                        sharedEdge.moves,
+                        sharedEdge.bytes });
+        }
+        return transitions;
+    }
+
+    // Writes the archetype graph as a DOT digraph, edges are weighted by how often entities moved along them
+    // Only edges that have been used are written
+    void WriteTransitionDot(std::ostream& stream)
+    {
+        const std::vector<Archetype*>& archetypes = Internal::Query<>::Get()->GetArchetypes(spaceId);
+        const auto getNode = [&archetypes](const Archetype* archetype) {
+            return std::find(archetypes.begin(), archetypes.end(), archetype) - archetypes.begin();
+        };
+        const auto getName = [](size_t componentId) {
+#ifdef ALLOY_EXPOSE_INTERNALS
+            return Internal::ComponentTypeTraits::GetComponentInfo()[componentId].name;
+#else
+            return "#" + std::to_string(componentId);
+#endif
+        };
+
+        stream << "digraph Space" << spaceId << " {" << std::endl;
+        for (size_t node = 0; node < archetypes.size(); ++node)
+        {
+            stream << "  a" << node << " [label=\"";
+            const ::Internal::BitSetContainer& mask = archetypes[node]->GetComponentMask().GetRawData();
+            bool empty = true;
+            for (size_t componentId = 0; componentId < mask.size(); ++componentId)
+            {
+                if (mask[componentId] == BitSet::False)
+                    continue;
+                stream << (empty ? "" : "\\n") << getName(componentId);
+                empty = false;
+            }
+            stream << (empty ? "(empty)" : "") << "\\n" << archetypes[node]->GetPool().GetSize() << " rows\"];" << std::endl;
+        }
+
+        for (const ArchetypeTransitionStats& transition : GetTransitionStats())
+        {
+            size_t width = 1;
+            for (size_t moves = transition.moves; moves > 1; moves >>= 1)
+                ++width;
+            stream << "  a" << getNode(transition.from) << " -> a" << getNode(transition.to)
+                   << " [label=\"" << (transition.added ? "+" : "-") << getName(transition.componentId)
+                   << "\\n" << transition.moves << " moves, " << transition.bytes << " B\", penwidth=" << width << "];" << std::endl;
+        }
+        stream << "}" << std::endl;
+    }
+#endif
+
+    // Constructs a resource, replacing any existing one of the same type
+    // Resources are per-space singletons stored outside of archetypes
+    template<typename Resource, typename... Args>
+    Resource& EmplaceResource(Args&&... args)
+    {
+        return resources.Emplace<Resource>(std::forward<Args>(args)...);
+    }
+
+    template<typename Resource>
+    void RemoveResource()
+    {
+        resources.Remove<Resource>();
+    }
+
+    template<typename Resource>
+    [[nodiscard]] bool HasResource() const
+    {
+        return resources.Has<Resource>();
+    }
+
+    template<typename Resource>
+    [[nodiscard]] Resource& GetResource()
+    {
+        return resources.Get<Resource>();
+    }
+
+    // Stable sort of every archetype holding a given component, keeping all of an entity's components together
+    // Comparator is called as comparator(const Component& lhs, const Component& rhs)
+    // Cheap to call every frame, already sorted archetypes are only checked
+    template<typename Component, typename Comparator>
+    void Sort(Comparator&& comparator)
+    {
+        static_assert(Internal::IsColumnComponent<Component>, "Only components stored in pool columns can be sorted.");
+        for (Archetype* archetype : Internal::Query<Component>::Get()->GetArchetypes(spaceId))
+            if (archetype->Sort<Component>(comparator, sortOrder))
+                entityManager.IncrementStructuralVersion();
+    }
+
+    // Sets the parent of a given entity, replacing any existing parent
+    // Destroying a parent turns its children into roots
+    void SetParent(const Entity child, const Entity parent)
+    {
+        ALLOY_ASSERT(IsValid(child), "Given child is not valid.");
+        ALLOY_ASSERT(IsValid(parent), "Given parent is not valid.");
+        entityManager.GetHierarchy().SetParent(child, parent);
+    }
+
+    // Detaches a given entity from its parent, if it has one
+    void RemoveParent(const Entity child)
+    {
+        entityManager.GetHierarchy().RemoveParent(child);
+    }
+
+    [[nodiscard]] bool HasParent(const Entity child)
+    {
+        return entityManager.GetHierarchy().HasParent(child);
+    }
+
+    // Returns an invalid entity if the given entity has no parent
+    [[nodiscard]] Entity GetParent(const Entity child)
+    {
+        return entityManager.GetHierarchy().GetParent(child);
+    }
+
+    // Calls a given function for every direct child of a given entity
+    template<typename Function>
+    void EachChild(const Entity parent, Function&& function)
+    {
+        entityManager.GetHierarchy().EachChild(parent, std::forward<Function>(function));
+    }
+
+    // Update a component system in depth order, parents strictly before their children
+    // The function is passed the entity, its components, then pointers to its parent's components (nullptr for roots)
+    // Parentless entities are updated first, archetype by archetype, followed by children in breadth-first order
+    // The parent's components are for reading, they may be copies of the parent's rows
+    template<typename... Components, typename UpdateFunction, typename... Args>
+    void UpdateHierarchy(UpdateFunction&& updateFunction, Args&&... args)
+    {
+        Internal::Hierarchy& hierarchy = entityManager.GetHierarchy();
         std::vector<Archetype*>& archetypes = Internal::Query<Components...>::Get()->GetArchetypes(spaceId);
 
-        // TODO: Build an iterator (?)
         for (Archetype* archetype : archetypes)
             archetype->GetPool().Update<Components...>(
-                std::forward<UpdateFunction>(updateFunction),
+                std::array<uint8_t*, sizeof...(Components)>{},
+                [&hierarchy, &updateFunction](const Entity entity, Components&... components, Args&&... arguments) {
+                    if (!hierarchy.HasParent(entity))
+                        updateFunction(entity, components..., static_cast<Components*>(nullptr)..., std::forward<Args>(arguments)...);
+                },
                 std::forward<Args>(args)...);
+
+        entityManager.UpdateHierarchy<Components...>(std::forward<UpdateFunction>(updateFunction), std::forward<Args>(args)...);
     }
 
     static void RegisterQuery(Internal::QueryInterface* queryInterface)
@@ -202,9 +465,99 @@ public:
 #endif
 
 private:
+    // Data for terms that are not read from pools, resolved once per update
+    template<bool PassEntity, typename... Terms, typename UpdateFunction, typename... Args>
+    void UpdateTerms(UpdateFunction&& updateFunction, Args&&... args)
+    {
+        std::vector<Archetype*>& archetypes = Internal::QueryFor<Terms...>::Get()->GetArchetypes(spaceId);
+        const std::array<uint8_t*, sizeof...(Terms)> externalData{ GetExternalTermData<Terms>()... };
+
+#ifdef ALLOY_INSTRUMENTATION
+        size_t visitedRows = 0;
+        size_t emptyArchetypes = 0;
+        for (Archetype* archetype : archetypes)
+        {
+            visitedRows += archetype->GetPool().GetSize();
+            emptyArchetypes += archetype->GetPool().GetSize() == 0;
+        }
+        Internal::ScopedUpdateTimer<Terms...> updateTimer(spaceId, visitedRows, archetypes.size(), emptyArchetypes);
+#endif
+
+        if constexpr (Internal::HasSparseTerms<Terms...>)
+        {
+            // Join from the smallest sparse set if it holds fewer entities than the matching archetypes
+            const Internal::SparseSetInterface* drivingSet = nullptr;
+            size_t term = 0;
+            (SelectSmallerSparseSet<Terms>(externalData[term++], drivingSet), ...);
+
+            size_t archetypeRows = 0;
+            for (Archetype* archetype : archetypes)
+                archetypeRows += archetype->GetPool().GetSize();
+
+            if (drivingSet->GetSize() < archetypeRows)
+            {
+#ifdef ALLOY_INSTRUMENTATION
+                updateTimer.SetRows(drivingSet->GetSize());
+#endif
+                entityManager.UpdateFromSparseSet<PassEntity, Terms...>(
+                    *drivingSet,
+                    externalData,
+                    std::forward<UpdateFunction>(updateFunction),
+                    std::forward<Args>(args)...);
+                return;
+            }
+        }
+
+        // TODO: Build an iterator (?)
+        for (Archetype* archetype : archetypes)
+        {
+            if constexpr (PassEntity)
+                archetype->GetPool().Update<Terms...>(
+                    externalData,
+                    std::forward<UpdateFunction>(updateFunction),
+                    std::forward<Args>(args)...);
+            else
+                archetype->GetPool().Each<Terms...>(
+                    externalData,
+                    std::forward<UpdateFunction>(updateFunction),
+                    std::forward<Args>(args)...);
+        }
+    }
+
+    template<bool PassEntity, typename... Terms, typename UpdateFunction>
+    void EachHelper(Internal::TypeList<Terms...>, UpdateFunction&& updateFunction)
+    {
+        UpdateTerms<PassEntity, Terms...>(std::forward<UpdateFunction>(updateFunction));
+    }
+
+    template<typename Term>
+    [[nodiscard]] uint8_t* GetExternalTermData()
+    {
+        if constexpr (Internal::TermTraits<Term>::Kind == Internal::TermKind::Resource)
+            return reinterpret_cast<uint8_t*>(&resources.Get<typename Internal::TermTraits<Term>::ResourceType>());
+        else if constexpr (Internal::TermTraits<Term>::Kind == Internal::TermKind::Sparse)
+            return reinterpret_cast<uint8_t*>(&entityManager.GetSparseStorage().Get<typename Internal::TermTraits<Term>::ComponentType>());
+        else
+            return nullptr;
+    }
+
+    template<typename Term>
+    static void SelectSmallerSparseSet(uint8_t* data, const Internal::SparseSetInterface*& smallest)
+    {
+        if constexpr (Internal::TermTraits<Term>::Kind == Internal::TermKind::Sparse)
+        {
+            const Internal::SparseSetInterface* sparseSet = reinterpret_cast<Internal::SparseSet<typename Internal::TermTraits<Term>::ComponentType>*>(data);
+            if (smallest == nullptr || sparseSet->GetSize() < smallest->GetSize())
+                smallest = sparseSet;
+        }
+    }
+
     size_t spaceId;
     Internal::ArchetypeMap archetypeMap;
     Internal::EntityManager entityManager;
+    Internal::ResourceStorage resources{};
+    // Scratch row order reused between sorts
+    std::vector<Internal::Pool::IndexType> sortOrder{};
 
     inline static RecycledCounter<size_t> spaceCounter;
     inline static std::vector<Space*> spaces;
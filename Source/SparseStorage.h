@@ -0,0 +1,185 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Alloy/AlloyConfig.h"
+#include "ComponentTypeTraits.h"
+#include "Entity.h"
+#include "MemoryStats.h"
+
+namespace X::Internal
+{
+
+// Entity <-> dense index bookkeeping shared by every sparse set
+class SparseSetInterface
+{
+public:
+    static constexpr size_t InvalidIndex = std::numeric_limits<size_t>::max();
+
+    virtual ~SparseSetInterface() = default;
+
+    // Removes the entity's component, swapping the last one into its place
+    virtual void Remove(Entity entity) = 0;
+
+    virtual void Clear() = 0;
+
+    [[nodiscard]] virtual size_t GetReservedBytes() const
+    {
+        return Internal::GetReservedBytes(entities) + Internal::GetReservedBytes(sparse);
+    }
+
+    [[nodiscard]] bool Contains(const Entity entity) const
+    {
+        return entity < sparse.size() && sparse[entity] < entities.size() && entities[sparse[entity]] == entity;
+    }
+
+    [[nodiscard]] size_t GetSize() const
+    {
+        return entities.size();
+    }
+
+    [[nodiscard]] const std::vector<Entity>& GetEntities() const
+    {
+        return entities;
+    }
+
+protected:
+    size_t Push(const Entity entity)
+    {
+        if (sparse.size() <= entity)
+        {
+            IdType v = entity + 1;
+            --v;
+            v |= v >> 1;
+            v |= v >> 2;
+            v |= v >> 4;
+            v |= v >> 8;
+            v |= v >> 16;
+            ++v;
+            sparse.resize(v, InvalidIndex);
+        }
+        sparse[entity] = entities.size();
+        entities.emplace_back(entity);
+        return sparse[entity];
+    }
+
+    // Returns the index the entity was removed from, the last entity is moved there
+    size_t Pop(const Entity entity)
+    {
+        const size_t index = sparse[entity];
+        const Entity last = entities.back();
+        entities[index] = last;
+        sparse[last] = index;
+        entities.pop_back();
+        sparse[entity] = InvalidIndex;
+        return index;
+    }
+
+    // Dense index -> Entity
+    std::vector<Entity> entities{};
+    // Entity ID -> Dense index
+    SparseSetContainer<size_t> sparse{};
+};
+
+// Packed storage for a single sparse component type, living outside of archetypes
+// Adding or removing the component never moves the entity's other components
+template<typename Component>
+class SparseSet final : public SparseSetInterface
+{
+public:
+    template<typename... Args>
+    Component& Emplace(const Entity entity, Args&&... args)
+    {
+        ALLOY_ASSERT(!Contains(entity), "Entity already has the component that is being added.");
+        Push(entity);
+        if constexpr (std::is_aggregate_v<Component>)
+            return components.emplace_back(Component{ std::forward<Args>(args)... });
+        else
+            return components.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void Remove(const Entity entity) final
+    {
+        ALLOY_ASSERT(Contains(entity), "Entity does not have the component that is being removed.");
+        const size_t index = Pop(entity);
+        if (index != components.size() - 1)
+            components[index] = std::move(components.back());
+        components.pop_back();
+    }
+
+    void Clear() final
+    {
+        for (const Entity entity : entities)
+            sparse[entity] = InvalidIndex;
+        entities.clear();
+        components.clear();
+    }
+
+    [[nodiscard]] Component& Get(const Entity entity)
+    {
+        ALLOY_ASSERT(Contains(entity), "Entity does not hold the requested component.");
+        return components[sparse[entity]];
+    }
+
+    [[nodiscard]] size_t GetReservedBytes() const final
+    {
+        return SparseSetInterface::GetReservedBytes() + Internal::GetReservedBytes(components);
+    }
+
+private:
+    // Dense index -> Component
+    std::vector<Component> components{};
+};
+
+// Component ID -> Sparse set, for every sparse component used in a space
+class SparseStorage
+{
+public:
+    template<typename Component>
+    [[nodiscard]] SparseSet<Component>& Get()
+    {
+        const ComponentTypeTraits::ComponentId componentId = GetComponentId<Component>::value;
+        if (componentId >= sparseSets.size())
+            sparseSets.resize(componentId + 1);
+
+        std::unique_ptr<SparseSetInterface>& sparseSet = sparseSets[componentId];
+        if (sparseSet == nullptr)
+        {
+            sparseSet = std::make_unique<SparseSet<Component>>();
+            activeSets.emplace_back(sparseSet.get());
+        }
+        return static_cast<SparseSet<Component>&>(*sparseSet);
+    }
+
+    // Must be called before an entity is destroyed
+    void RemoveEntity(const Entity entity)
+    {
+        for (SparseSetInterface* sparseSet : activeSets)
+            if (sparseSet->Contains(entity))
+                sparseSet->Remove(entity);
+    }
+
+    void Clear()
+    {
+        for (SparseSetInterface* sparseSet : activeSets)
+            sparseSet->Clear();
+    }
+
+    [[nodiscard]] size_t GetReservedBytes() const
+    {
+        size_t bytes = Internal::GetReservedBytes(sparseSets) + Internal::GetReservedBytes(activeSets);
+        for (const SparseSetInterface* sparseSet : activeSets)
+            bytes += sparseSet->GetReservedBytes();
+        return bytes;
+    }
+
+private:
+    std::vector<std::unique_ptr<SparseSetInterface>> sparseSets{};
+    // Non-null entries of sparseSets, for fast iteration
+    std::vector<SparseSetInterface*> activeSets{};
+};
+
+} // namespace X::Internal
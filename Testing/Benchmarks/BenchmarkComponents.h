@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+
+// Components used by the scenario benchmarks
+// Also the ALLOY_STATIC_COMPONENTS header of the StaticComponents benchmark configuration, so it is included by Alloy itself
+
+// A distinct component type per index
+template<size_t Index>
+struct BenchmarkComponent
+{
+    float value = 1.0f;
+};
+
+namespace AlloyBenchmarks
+{
+
+// The first components are iterated, the rest only fragment worlds into archetypes
+constexpr size_t IteratedComponentCount = 8;
+constexpr size_t FragmentComponentCount = 10;
+
+} // namespace AlloyBenchmarks
+
+#ifdef ALLOY_STATIC_COMPONENTS
+
+template<size_t... Is>
+X::ComponentList<BenchmarkComponent<Is>...> MakeBenchmarkComponentList(std::index_sequence<Is...>);
+
+struct X::StaticComponents
+{
+    using Type = decltype(MakeBenchmarkComponentList(std::make_index_sequence<AlloyBenchmarks::IteratedComponentCount + AlloyBenchmarks::FragmentComponentCount>{}));
+};
+
+#endif
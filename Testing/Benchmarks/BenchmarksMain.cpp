@@ -0,0 +1,17 @@
+#include "benchmark/benchmark.h"
+#include <iostream>
+
+// ===== MODULES =====
+#include "Modules/ScenarioModule.h"
+// ===================
+
+int main(int argc, char** argv)
+{
+    std::cout << "[Running benchmarks]" << std::endl;
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+    std::cout << "[Running benchmarks completed]" << std::endl;
+    return 0;
+}
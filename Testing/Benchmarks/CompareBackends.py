@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Compares the storage backend benchmark binaries (AlloyBenchmarks_<Configuration>).
+
+Either runs every binary found in a build directory:
+    CompareBackends.py build/Testing --benchmark_filter='Iterate/'
+or compares JSON results written with --benchmark_out=<Configuration>.json --benchmark_out_format=json:
+    CompareBackends.py --json HeatVector.json UnorderedMap.json
+
+Prints one Markdown table per counter, entities/s relative to the baseline configuration and bytes/entity.
+"""
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+BINARY_PREFIX = "AlloyBenchmarks_"
+
+
+def run_binaries(directory, benchmark_arguments):
+    results = {}
+    for binary in sorted(glob.glob(os.path.join(directory, BINARY_PREFIX + "*"))):
+        if not os.access(binary, os.X_OK) or os.path.isdir(binary):
+            continue
+        configuration = os.path.basename(binary)[len(BINARY_PREFIX):]
+        print(f"Running {configuration}...", file=sys.stderr)
+        with tempfile.TemporaryDirectory() as outputDirectory:
+            output = os.path.join(outputDirectory, configuration + ".json")
+            subprocess.run([binary, "--benchmark_out=" + output, "--benchmark_out_format=json", *benchmark_arguments],
+                           check=True, stdout=subprocess.DEVNULL)
+            results[configuration] = json.load(open(output))
+    return results
+
+
+def load_json(paths):
+    return {os.path.splitext(os.path.basename(path))[0]: json.load(open(path)) for path in paths}
+
+
+def collect(results, counter):
+    # Benchmark name -> Configuration -> Counter value, aggregates (mean, median, ...) are skipped
+    table = {}
+    for configuration, result in results.items():
+        for benchmark in result["benchmarks"]:
+            if benchmark.get("run_type", "iteration") != "iteration" or counter not in benchmark:
+                continue
+            table.setdefault(benchmark["name"], {})[configuration] = benchmark[counter]
+    return table
+
+
+def print_table(title, table, configurations, relative):
+    print(f"\n### {title}\n")
+    print("| Benchmark | " + " | ".join(configurations) + " |")
+    print("|---" * (len(configurations) + 1) + "|")
+    for name, values in table.items():
+        baseline = values.get(configurations[0])
+        cells = []
+        for configuration in configurations:
+            value = values.get(configuration)
+            if value is None:
+                cells.append("-")
+            elif relative and baseline:
+                cells.append(f"{value:.3g} ({value / baseline:.2f}x)")
+            else:
+                cells.append(f"{value:.3g}")
+        print(f"| {name} | " + " | ".join(cells) + " |")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("directory", nargs="?", help="directory holding the AlloyBenchmarks_<Configuration> binaries")
+    parser.add_argument("--json", nargs="+", help="compare existing JSON results instead of running binaries")
+    parser.add_argument("--baseline", default="HeatVector", help="configuration the others are relative to (default: HeatVector)")
+    arguments, benchmark_arguments = parser.parse_known_args()
+
+    if arguments.json:
+        results = load_json(arguments.json)
+    elif arguments.directory:
+        results = run_binaries(arguments.directory, benchmark_arguments)
+    else:
+        parser.error("either a directory or --json is required")
+    if not results:
+        parser.error("no benchmark results found")
+
+    configurations = list(results)
+    if arguments.baseline in configurations:
+        configurations.remove(arguments.baseline)
+        configurations.insert(0, arguments.baseline)
+    print_table("entities/s (higher is better, relative to " + configurations[0] + ")",
+                collect(results, "entities/s"), configurations, True)
+    print_table("bytes/entity (lower is better)", collect(results, "bytes/entity"), configurations, False)
+
+
+if __name__ == "__main__":
+    main()
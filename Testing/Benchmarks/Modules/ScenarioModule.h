@@ -0,0 +1,353 @@
+#pragma once
+// Alloy first, with ALLOY_STATIC_COMPONENTS it includes the component list itself
+#include "Alloy/Alloy.h"
+#include "../BenchmarkComponents.h"
+#include "../PerfCounters.h"
+#include "benchmark/benchmark.h"
+#include <array>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Scenario benchmarks
+// Every scenario reports:
+// - entities/s: entities (or operations) processed per second
+// - bytes/entity: memory reserved by the space(s) per entity, see X::Space::GetMemoryStats
+// - with ALLOY_BENCHMARK_PERF_COUNTERS: instructions, cache, branch and dTLB misses per entity, see PerfCounters.h
+// - with ALLOY_COUNT_ALLOCATIONS: heap allocations per entity
+
+namespace AlloyBenchmarks
+{
+
+template<size_t Index>
+using FragmentComponent = BenchmarkComponent<IteratedComponentCount + Index>;
+
+template<size_t... Is>
+void EmplaceComponents(X::Space& space, const X::Entity entity, std::index_sequence<Is...>)
+{
+    (space.EmplaceComponent<BenchmarkComponent<Is>>(entity), ...);
+}
+
+// Adds the fragment components whose bits are set in the given mask
+template<size_t... Is>
+void EmplaceFragments(X::Space& space, const X::Entity entity, const size_t mask, std::index_sequence<Is...>)
+{
+    ((mask & (size_t(1) << Is) ? (void) space.EmplaceComponent<FragmentComponent<Is>>(entity) : (void) 0), ...);
+}
+
+template<size_t... Is>
+void UpdateComponents(X::Space& space, std::index_sequence<Is...>)
+{
+    space.Update<BenchmarkComponent<Is>...>([](X::Entity, BenchmarkComponent<Is>&... components) {
+        ((components.value += 1.0f), ...);
+    });
+}
+
+[[nodiscard]] inline double GetBytesPerEntity(X::Space& space, const size_t entities)
+{
+    return static_cast<double>(space.GetMemoryStats().reservedBytes) / static_cast<double>(entities);
+}
+
+inline void ReportEntities(benchmark::State& state, PerfCounters& perfCounters, const double entitiesPerIteration, const double bytesPerEntity)
+{
+    perfCounters.Report(state, entitiesPerIteration);
+    state.counters["entities/s"] = benchmark::Counter(entitiesPerIteration, benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["bytes/entity"] = bytesPerEntity;
+}
+
+// ==== Iteration ====
+// range(0): entities, range(1): components per entity and per update
+
+template<size_t ComponentCount>
+void IterateScenario(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    X::Space space{};
+    for (size_t i = 0; i < entities; ++i)
+        EmplaceComponents(space, space.CreateEntity(), std::make_index_sequence<ComponentCount>{});
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+        UpdateComponents(space, std::make_index_sequence<ComponentCount>{});
+
+    ReportEntities(state, perfCounters, static_cast<double>(entities), GetBytesPerEntity(space, entities));
+}
+
+template<size_t... Is>
+[[nodiscard]] constexpr auto MakeIterateScenarios(std::index_sequence<Is...>)
+{
+    return std::array<void (*)(benchmark::State&), sizeof...(Is)>{ &IterateScenario<Is + 1>... };
+}
+
+} // namespace AlloyBenchmarks
+
+static void Iterate(benchmark::State& state)
+{
+    static constexpr auto scenarios = AlloyBenchmarks::MakeIterateScenarios(std::make_index_sequence<AlloyBenchmarks::IteratedComponentCount>{});
+    scenarios[state.range(1) - 1](state);
+}
+BENCHMARK(Iterate)
+    ->ArgNames({ "entities", "components" })
+    ->ArgsProduct({ benchmark::CreateRange(1000, 10000000, 10), { 1, 2, 4, 8 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// ==== Fragmented iteration ====
+// range(0): entities, range(1): archetypes the entities are spread over
+
+static void IterateFragmented(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    const size_t archetypes = static_cast<size_t>(state.range(1));
+    X::Space space{};
+    for (size_t i = 0; i < entities; ++i)
+    {
+        const X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<BenchmarkComponent<0>>(entity);
+        AlloyBenchmarks::EmplaceFragments(space, entity, i % archetypes, std::make_index_sequence<AlloyBenchmarks::FragmentComponentCount>{});
+    }
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+        AlloyBenchmarks::UpdateComponents(space, std::make_index_sequence<1>{});
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), AlloyBenchmarks::GetBytesPerEntity(space, entities));
+}
+BENCHMARK(IterateFragmented)
+    ->ArgNames({ "entities", "archetypes" })
+    ->ArgsProduct({ { 10000, 100000, 1000000 }, { 1, 32, 1024 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// ==== Add/remove churn ====
+// range(0): entities, each gains and loses a component every iteration
+
+static void AddRemoveChurn(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    X::Space space{};
+    std::vector<X::Entity> handles{};
+    for (size_t i = 0; i < entities; ++i)
+    {
+        handles.emplace_back(space.CreateEntity());
+        AlloyBenchmarks::EmplaceComponents(space, handles.back(), std::make_index_sequence<4>{});
+    }
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+    {
+        for (const X::Entity entity : handles)
+            space.EmplaceComponent<BenchmarkComponent<4>>(entity);
+        for (const X::Entity entity : handles)
+            space.RemoveComponent<BenchmarkComponent<4>>(entity);
+    }
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), AlloyBenchmarks::GetBytesPerEntity(space, entities));
+}
+BENCHMARK(AddRemoveChurn)
+    ->ArgNames({ "entities" })
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// ==== Create/destroy storms ====
+// range(0): entities created, with two components, and destroyed every iteration
+
+static void CreateDestroyStorm(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    X::Space space{};
+    std::vector<X::Entity> handles(entities);
+    double bytesPerEntity = 0.0;
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < entities; ++i)
+        {
+            handles[i] = space.CreateEntity();
+            AlloyBenchmarks::EmplaceComponents(space, handles[i], std::make_index_sequence<2>{});
+        }
+
+        state.PauseTiming();
+        perfCounters.Stop();
+        bytesPerEntity = AlloyBenchmarks::GetBytesPerEntity(space, entities);
+        perfCounters.Start();
+        state.ResumeTiming();
+
+        for (const X::Entity entity : handles)
+            space.DestroyEntity(entity);
+    }
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), bytesPerEntity);
+}
+BENCHMARK(CreateDestroyStorm)
+    ->ArgNames({ "entities" })
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// range(0): entities created, with two components, then all destroyed every iteration (only the destruction is timed)
+// range(1): 0 destroys them one by one through X::Space::DestroyAllEntities, 1 at once through X::Space::Clear
+
+static void ClearSpace(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    const bool bulk = state.range(1) != 0;
+    X::Space space{};
+    double bytesPerEntity = 0.0;
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        perfCounters.Stop();
+        for (size_t i = 0; i < entities; ++i)
+            AlloyBenchmarks::EmplaceComponents(space, space.CreateEntity(), std::make_index_sequence<2>{});
+        bytesPerEntity = AlloyBenchmarks::GetBytesPerEntity(space, entities);
+        perfCounters.Start();
+        state.ResumeTiming();
+
+        if (bulk)
+            space.Clear();
+        else
+            space.DestroyAllEntities();
+    }
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), bytesPerEntity);
+}
+BENCHMARK(ClearSpace)
+    ->ArgNames({ "entities", "bulk" })
+    ->ArgsProduct({ { 1000, 100000, 1000000 }, { 0, 1 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// range(0): entities created, with two components, and updated once per iteration, like a short-lived match
+// range(1): 0 uses a new space every iteration, 1 reuses one space through X::Space::Reset
+
+static void SpaceReuse(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    const bool reuse = state.range(1) != 0;
+    std::unique_ptr<X::Space> space = std::make_unique<X::Space>();
+    double bytesPerEntity = 0.0;
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+    {
+        if (reuse)
+            space->Reset();
+        else
+            space = std::make_unique<X::Space>();
+
+        for (size_t i = 0; i < entities; ++i)
+            AlloyBenchmarks::EmplaceComponents(*space, space->CreateEntity(), std::make_index_sequence<2>{});
+        AlloyBenchmarks::UpdateComponents(*space, std::make_index_sequence<2>{});
+
+        state.PauseTiming();
+        perfCounters.Stop();
+        bytesPerEntity = AlloyBenchmarks::GetBytesPerEntity(*space, entities);
+        perfCounters.Start();
+        state.ResumeTiming();
+    }
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), bytesPerEntity);
+}
+BENCHMARK(SpaceReuse)
+    ->ArgNames({ "entities", "reuse" })
+    ->ArgsProduct({ { 100, 10000, 1000000 }, { 0, 1 } })
+    ->Unit(benchmark::kMicrosecond);
+
+// ==== Random access ====
+// range(0): entities, each fetched once per iteration in a random order
+
+static void RandomGetComponent(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    X::Space space{};
+    std::vector<X::Entity> handles{};
+    for (size_t i = 0; i < entities; ++i)
+    {
+        handles.emplace_back(space.CreateEntity());
+        AlloyBenchmarks::EmplaceComponents(space, handles.back(), std::make_index_sequence<2>{});
+    }
+    std::shuffle(handles.begin(), handles.end(), std::mt19937_64(entities));
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+    {
+        float sum = 0.0f;
+        for (const X::Entity entity : handles)
+            sum += space.GetComponentTemporary<BenchmarkComponent<1>>(entity).value;
+        benchmark::DoNotOptimize(sum);
+    }
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), AlloyBenchmarks::GetBytesPerEntity(space, entities));
+}
+BENCHMARK(RandomGetComponent)
+    ->ArgNames({ "entities" })
+    ->RangeMultiplier(10)
+    ->Range(1000, 10000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Same access pattern through X::Space::Gather
+static void RandomGather(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    X::Space space{};
+    std::vector<X::Entity> handles{};
+    for (size_t i = 0; i < entities; ++i)
+    {
+        handles.emplace_back(space.CreateEntity());
+        AlloyBenchmarks::EmplaceComponents(space, handles.back(), std::make_index_sequence<2>{});
+    }
+    std::shuffle(handles.begin(), handles.end(), std::mt19937_64(entities));
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+    {
+        float sum = 0.0f;
+        space.Gather<BenchmarkComponent<1>>(handles, [&sum](X::Entity, BenchmarkComponent<1>& component) {
+            sum += component.value;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), AlloyBenchmarks::GetBytesPerEntity(space, entities));
+}
+BENCHMARK(RandomGather)
+    ->ArgNames({ "entities" })
+    ->RangeMultiplier(10)
+    ->Range(1000, 10000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// ==== Multiple spaces ====
+// range(0): entities in total, range(1): spaces they are spread over, all updated through X::Update
+
+static void MultiSpaceIterate(benchmark::State& state)
+{
+    const size_t entities = static_cast<size_t>(state.range(0));
+    const size_t spaceCount = static_cast<size_t>(state.range(1));
+    std::vector<std::unique_ptr<X::Space>> spaces{};
+    for (size_t i = 0; i < spaceCount; ++i)
+        spaces.emplace_back(std::make_unique<X::Space>());
+    for (size_t i = 0; i < entities; ++i)
+    {
+        X::Space& space = *spaces[i % spaceCount];
+        AlloyBenchmarks::EmplaceComponents(space, space.CreateEntity(), std::make_index_sequence<2>{});
+    }
+
+    AlloyBenchmarks::PerfCounters perfCounters{};
+    for (auto _ : state)
+        X::Update<BenchmarkComponent<0>, BenchmarkComponent<1>>([](X::Space&, X::Entity, BenchmarkComponent<0>& first, BenchmarkComponent<1>& second) {
+            first.value += second.value;
+        });
+
+    double reservedBytes = 0.0;
+    for (const std::unique_ptr<X::Space>& space : spaces)
+        reservedBytes += static_cast<double>(space->GetMemoryStats().reservedBytes);
+    AlloyBenchmarks::ReportEntities(state, perfCounters, static_cast<double>(entities), reservedBytes / static_cast<double>(entities));
+}
+BENCHMARK(MultiSpaceIterate)
+    ->ArgNames({ "entities", "spaces" })
+    ->ArgsProduct({ { 100000, 1000000 }, { 1, 4, 16 } })
+    ->Unit(benchmark::kMicrosecond);
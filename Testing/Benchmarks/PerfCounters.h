@@ -0,0 +1,126 @@
+#pragma once
+#include "../Source/AllocationCounter.h"
+#include "benchmark/benchmark.h"
+#include <array>
+#include <cstdint>
+
+// Hardware performance counters, compiled in with ALLOY_BENCHMARK_PERF_COUNTERS on Linux
+// Counters are read through perf_event_open, user space only. Events the kernel or CPU refuses (no PMU in a VM,
+// perf_event_paranoid too high) are skipped, so a benchmark always runs and only reports what could be counted
+// With ALLOY_COUNT_ALLOCATIONS heap allocations are counted the same way
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace AlloyBenchmarks
+{
+
+class PerfCounters
+{
+public:
+    // Counting starts right away
+    PerfCounters()
+    {
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+        for (size_t i = 0; i < EventCount; ++i)
+        {
+            perf_event_attr attributes{};
+            attributes.size = sizeof(perf_event_attr);
+            attributes.type = Events[i].type;
+            attributes.config = Events[i].config;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptors[i] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+#endif
+        Start();
+    }
+
+    ~PerfCounters()
+    {
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+        for (int descriptor : descriptors)
+            if (descriptor >= 0)
+                close(descriptor);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Counting may be stopped and started again around untimed work, counts accumulate
+    void Start()
+    {
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+        for (int descriptor : descriptors)
+            if (descriptor >= 0)
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+#ifdef ALLOY_COUNT_ALLOCATIONS
+        allocationCounter = AlloyTesting::AllocationCounter{};
+#endif
+    }
+
+    void Stop()
+    {
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+        for (int descriptor : descriptors)
+            if (descriptor >= 0)
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+#ifdef ALLOY_COUNT_ALLOCATIONS
+        allocations += allocationCounter.GetCount();
+        allocationCounter = AlloyTesting::AllocationCounter{};
+#endif
+    }
+
+    // Adds one "<event>/entity" counter per available event, averaged over the benchmark's iterations
+    void Report([[maybe_unused]] benchmark::State& state, [[maybe_unused]] const double entitiesPerIteration)
+    {
+        Stop();
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+        for (size_t i = 0; i < EventCount; ++i)
+        {
+            uint64_t count = 0;
+            if (descriptors[i] < 0 || read(descriptors[i], &count, sizeof(count)) != sizeof(count))
+                continue;
+            state.counters[Events[i].name] = benchmark::Counter(static_cast<double>(count) / entitiesPerIteration, benchmark::Counter::kAvgIterations);
+        }
+#endif
+#ifdef ALLOY_COUNT_ALLOCATIONS
+        state.counters["allocations/entity"] = benchmark::Counter(static_cast<double>(allocations) / entitiesPerIteration, benchmark::Counter::kAvgIterations);
+#endif
+    }
+
+private:
+#if defined(ALLOY_BENCHMARK_PERF_COUNTERS) && defined(__linux__)
+    struct Event
+    {
+        const char* name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    static constexpr size_t EventCount = 4;
+    static constexpr std::array<Event, EventCount> Events{ {
+        { "instructions/entity", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { "cache-misses/entity", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { "branch-misses/entity", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { "dTLB-misses/entity",
+          PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    } };
+
+    std::array<int, EventCount> descriptors{};
+#endif
+#ifdef ALLOY_COUNT_ALLOCATIONS
+    AlloyTesting::AllocationCounter allocationCounter{};
+    size_t allocations{ 0 };
+#endif
+};
+
+} // namespace AlloyBenchmarks
@@ -0,0 +1,50 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete, counting allocations per thread
+// Only added to the test and benchmark executables with ALLOY_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size)
+{
+    ++AlloyTesting::AllocationCounter::GetThreadCount();
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++AlloyTesting::AllocationCounter::GetThreadCount();
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+// Global allocation counting, compiled in with ALLOY_COUNT_ALLOCATIONS
+// The replacement global operator new and delete live in AllocationCounter.cpp, only built into executables with ALLOY_COUNT_ALLOCATIONS
+// Only allocations made by the counting thread are counted, other threads (benchmark or test runners) are ignored
+
+namespace AlloyTesting
+{
+
+class AllocationCounter
+{
+public:
+    // Number of allocations on this thread since the counter was created
+    [[nodiscard]] size_t GetCount() const
+    {
+        return GetThreadCount() - start;
+    }
+
+    [[nodiscard]] static size_t& GetThreadCount()
+    {
+        thread_local size_t count = 0;
+        return count;
+    }
+
+private:
+    size_t start{ GetThreadCount() };
+};
+
+} // namespace AlloyTesting
@@ -1,7 +1,12 @@
 #pragma once
+#include "../AllocationCounter.h"
 #include "Alloy/Alloy.h"
+#include "TestComponents.h"
 #include "benchmark/benchmark.h"
 #include "gtest/gtest.h"
+#include <memory>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #ifndef COMPONENT_COUNt_REF
@@ -11,43 +16,6 @@
     #define LOOPS 1000
 #endif
 
-struct CFirst
-{
-    long unsigned e;
-    long unsigned c;
-};
-
-struct CSecond
-{
-    long unsigned e;
-    long unsigned c;
-};
-
-struct CThird
-{
-    long unsigned a;
-    long unsigned b;
-};
-
-struct PositionComponent
-{
-    float x = 0.0f;
-    float y = 0.0f;
-};
-
-struct DirectionComponent
-{
-    float x = 0.0f;
-    float y = 0.0f;
-};
-
-struct ComflabulationComponent
-{
-    float thingy = 0.0;
-    long unsigned dingy = 0;
-    bool mingy = false;
-};
-
 TEST(Alloy, BasicComponentUsage)
 {
     X::Space space1{};
@@ -281,10 +249,7 @@ BENCHMARK(Create10Vectors);
 
 static void EmplaceRemoveComponent(benchmark::State& state)
 {
-    struct Component
-    {
-        int var;
-    };
+    using namespace AlloyTesting::EmplaceRemoveComponent;
 
     X::Space space{};
     X::Entity entity = space.CreateEntity();
@@ -298,10 +263,7 @@ BENCHMARK(EmplaceRemoveComponent);
 
 static void InsertRemoveComponent(benchmark::State& state)
 {
-    struct Component
-    {
-        int var;
-    };
+    using namespace AlloyTesting::InsertRemoveComponent;
 
     X::Space space{};
     X::Entity entity = space.CreateEntity();
@@ -316,10 +278,7 @@ BENCHMARK(InsertRemoveComponent);
 
 static void Get1KComponent(benchmark::State& state)
 {
-    struct Component
-    {
-        int var;
-    };
+    using namespace AlloyTesting::Get1KComponent;
 
     X::Space space{};
     X::Entity entity = space.CreateEntity();
@@ -337,10 +296,7 @@ BENCHMARK(Get1KComponent);
 
 static void Get1KComponentTemporary(benchmark::State& state)
 {
-    struct Component
-    {
-        int var;
-    };
+    using namespace AlloyTesting::Get1KComponentTemporary;
 
     X::Space space{};
     X::Entity entity = space.CreateEntity();
@@ -433,10 +389,7 @@ TEST(Alloy, TestGenerations)
 
 static void UpdateOn1KEntities(benchmark::State& state)
 {
-    struct Component
-    {
-        int ivar;
-    };
+    using namespace AlloyTesting::UpdateOn1KEntities;
 
     X::Space space{};
 
@@ -457,15 +410,7 @@ BENCHMARK(UpdateOn1KEntities);
 
 static void UpdateOn1KEntities2Components(benchmark::State& state)
 {
-    struct Component
-    {
-        int ivar;
-    };
-
-    struct Component2
-    {
-        int ivar;
-    };
+    using namespace AlloyTesting::UpdateOn1KEntities2Components;
 
     X::Space space{};
 
@@ -488,11 +433,7 @@ BENCHMARK(UpdateOn1KEntities2Components);
 
 static void CreateDestroy100EntitiesInOrderWithOneComponent(benchmark::State& state)
 {
-    struct Component
-    {
-        int a;
-        int b;
-    };
+    using namespace AlloyTesting::CreateDestroy100EntitiesInOrderWithOneComponent;
 
     X::Space space{};
     std::vector<X::Entity> entities{};
@@ -519,11 +460,7 @@ BENCHMARK(CreateDestroy100EntitiesInOrderWithOneComponent);
 
 static void CreateDestroy10EntitiesReverseOrderWithOneComponent(benchmark::State& state)
 {
-    struct Component
-    {
-        int a;
-        int b;
-    };
+    using namespace AlloyTesting::CreateDestroy10EntitiesReverseOrderWithOneComponent;
 
     X::Space space{};
     std::vector<X::Entity> entities{};
@@ -546,29 +483,22 @@ static void CreateDestroy10EntitiesReverseOrderWithOneComponent(benchmark::State
 }
 BENCHMARK(CreateDestroy10EntitiesReverseOrderWithOneComponent);
 
-TEST(Alloy, EmplaceIsValid)
+inline AlloyTesting::EmplaceIsValid::Component2::Component2(X::Space& space, X::Entity entity)
 {
-    struct Component1
+    if (!space.IsValid(entity))
     {
-        int a{ 1 };
-    };
+        exit(1);
+    }
 
-    struct Component2
+    if (!space.HasComponent<Component1>(entity))
     {
-        Component2(X::Space& space, X::Entity entity)
-        {
-            if (!space.IsValid(entity))
-            {
-                exit(1);
-            }
-
-            if (!space.HasComponent<Component1>(entity))
-            {
-                exit(1);
-            }
-        }
-        int b{ 2 };
-    };
+        exit(1);
+    }
+}
+
+TEST(Alloy, EmplaceIsValid)
+{
+    using namespace AlloyTesting::EmplaceIsValid;
 
     X::Space space{};
     X::Entity entity = space.CreateEntity();
@@ -579,35 +509,7 @@ TEST(Alloy, EmplaceIsValid)
 
 TEST(Alloy, ComponentDataValidation)
 {
-    struct Component1
-    {
-        std::string string{};
-        std::vector<int> vector{};
-
-        Component1() {}
-
-        //        int& a;
-
-        //        Component1(const Component1& other) : string(other.string), vector(other.vector), a(other.a)
-        //        {}
-        //
-        Component1(const std::string& string, const std::vector<int> vector, int& a) : string(string), vector(vector) /*, a(a)*/
-        {}
-
-        Component1(const Component1& other) = delete;
-        Component1& operator=(const Component1& other)
-        {
-            string = other.string;
-            vector = other.vector;
-            //            a = other.a;
-            return *this;
-        }
-    };
-
-    struct Component2
-    {
-        int a;
-    };
+    using namespace AlloyTesting::ComponentDataValidation;
 
     X::Space space{};
     X::Entity entity = space.CreateEntity();
@@ -669,6 +571,8 @@ TEST(Alloy, ManySpaces)
 }
 TEST(Alloy, Random)
 {
+    using namespace AlloyTesting::Random;
+
     X::Space space1{};
     X::Entity entityInvalid{};
     X::Entity entity1 = space1.CreateEntity();
@@ -676,10 +580,6 @@ TEST(Alloy, Random)
     X::Entity entityDestroyed = space1.CreateEntity();
     space1.DestroyEntity(entityDestroyed);
 
-    struct DebugComponent
-    {
-    };
-
     space1.EmplaceComponent<DebugComponent>(entity2);
     //    X::GetInfo(space1, entityInvalid);
     //    X::GetInfo(space1, entity1);
@@ -687,3 +587,986 @@ TEST(Alloy, Random)
     //    X::GetInfo(space1, entityDestroyed);
     //    X::GetInfo(space1);
 }
+
+TEST(Alloy, Hierarchy)
+{
+    using namespace AlloyTesting::Hierarchy;
+
+    X::Space space{};
+    X::Entity root = space.CreateEntity();
+    X::Entity child = space.CreateEntity();
+    X::Entity grandchild = space.CreateEntity();
+    X::Entity loner = space.CreateEntity();
+
+    // Created in reverse order so the archetype order differs from the depth order
+    space.EmplaceComponent<Transform>(grandchild, 100, 0);
+    space.EmplaceComponent<Transform>(child, 10, 0);
+    space.EmplaceComponent<Transform>(root, 1, 0);
+    space.EmplaceComponent<Transform>(loner, 1000, 0);
+
+    space.SetParent(grandchild, child);
+    space.SetParent(child, root);
+    ASSERT_TRUE(space.GetParent(grandchild) == child) << "Parent was not set correctly.";
+    ASSERT_FALSE(space.HasParent(root)) << "Root should not have a parent.";
+
+    int childCount = 0;
+    space.EachChild(root, [&](X::Entity entity) {
+        ASSERT_TRUE(entity == child) << "Unexpected child.";
+        ++childCount;
+    });
+    ASSERT_TRUE(childCount == 1) << "Child count is incorrect.";
+
+    int visited = 0;
+    space.UpdateHierarchy<Transform>([&visited](X::Entity, Transform& transform, Transform* parent) {
+        transform.world = transform.local + (parent ? parent->world : 0);
+        ++visited;
+    });
+    ASSERT_TRUE(visited == 4) << "Every entity holding the component should be visited once.";
+    ASSERT_TRUE(space.GetComponentTemporary<Transform>(grandchild).world == 111) << "Parents were not updated before children.";
+    ASSERT_TRUE(space.GetComponentTemporary<Transform>(loner).world == 1000) << "Parentless entity was not updated.";
+
+    // Moving rows between archetypes invalidates the cached node rows
+    space.EmplaceComponent<PositionComponent>(child, 0.0f, 0.0f);
+    space.GetComponentTemporary<Transform>(root).local = 2;
+    space.UpdateHierarchy<Transform>([](X::Entity, Transform& transform, Transform* parent) {
+        transform.world = transform.local + (parent ? parent->world : 0);
+    });
+    ASSERT_TRUE(space.GetComponentTemporary<Transform>(grandchild).world == 112) << "Moved rows were not updated.";
+
+    // Components that are not trivially copyable are updated in place
+    space.EmplaceComponent<Path>(root, "root");
+    space.EmplaceComponent<Path>(child, "child");
+    space.EmplaceComponent<Path>(grandchild, "grandchild");
+    space.UpdateHierarchy<Path>([](X::Entity, Path& path, Path* parent) {
+        if (parent)
+            path.name = parent->name + "/" + path.name;
+    });
+    ASSERT_TRUE(space.GetComponentTemporary<Path>(grandchild).name == "root/child/grandchild") << "Paths were not updated in depth order.";
+
+    // Destroying a parent orphans its children
+    space.DestroyEntity(child);
+    ASSERT_FALSE(space.HasParent(grandchild)) << "Children of destroyed entities should become roots.";
+    space.UpdateHierarchy<Transform>([](X::Entity, Transform& transform, Transform* parent) {
+        transform.world = transform.local + (parent ? parent->world : 0);
+    });
+    ASSERT_TRUE(space.GetComponentTemporary<Transform>(grandchild).world == 100) << "Orphaned child should be a root.";
+}
+
+TEST(Alloy, SortByComponent)
+{
+    using namespace AlloyTesting::SortByComponent;
+
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < COMPONENT_COUNT_REF; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<Key>(entity, (i * 7919) % 97);
+        space.EmplaceComponent<Name>(entity, std::to_string(i));
+        entities.emplace_back(entity);
+    }
+
+    auto byKey = [](const Key& lhs, const Key& rhs) {
+        return lhs.value < rhs.value;
+    };
+    space.Sort<Key>(byKey);
+
+    int previousKey = -1;
+    X::IdType previousId = 0;
+    space.Update<Key, Name>([&](X::Entity entity, Key& key, Name&) {
+        ASSERT_TRUE(key.value >= previousKey) << "Rows are not sorted.";
+        if (key.value == previousKey)
+        {
+            ASSERT_TRUE(entity.GetId() > previousId) << "Sort is not stable.";
+        }
+        previousKey = key.value;
+        previousId = entity.GetId();
+    });
+
+    // Every entity must still find its own row
+    for (int i = 0; i < COMPONENT_COUNT_REF; ++i)
+    {
+        ASSERT_TRUE(space.GetComponentTemporary<Key>(entities[i]).value == (i * 7919) % 97) << "Entity lost its row.";
+        ASSERT_TRUE(space.GetComponentTemporary<Name>(entities[i]).name == std::to_string(i)) << "Columns were not permuted together.";
+    }
+
+    // Nearly sorted input is fixed incrementally
+    space.GetComponentTemporary<Key>(entities[0]).value = -1;
+    space.Sort<Key>(byKey);
+    bool first = true;
+    space.Update<Key>([&](X::Entity entity, Key&) {
+        if (first)
+        {
+            ASSERT_TRUE(entity == entities[0]) << "Moved row was not sorted to the front.";
+        }
+        first = false;
+    });
+}
+
+TEST(Alloy, Resources)
+{
+    struct Clock
+    {
+        float dt;
+    };
+
+    struct Gravity
+    {
+        float value;
+    };
+
+    X::Space space{};
+    ASSERT_FALSE(space.HasResource<Clock>()) << "Space should start without resources.";
+    space.EmplaceResource<Clock>(0.5f);
+    space.EmplaceResource<Gravity>(-10.0f);
+    ASSERT_TRUE(space.GetResource<Clock>().dt == 0.5f) << "Resource data is incorrect.";
+
+    for (int i = 0; i < 10; ++i)
+        space.EmplaceComponent<PositionComponent>(space.CreateEntity(), 0.0f, 0.0f);
+
+    space.Update<X::Resource<Clock>, PositionComponent, X::Resource<Gravity>>(
+        [](X::Entity, Clock& clock, PositionComponent& position, Gravity& gravity) {
+            position.y += gravity.value * clock.dt;
+        });
+    space.Update<PositionComponent>([](X::Entity, PositionComponent& position) {
+        ASSERT_TRUE(position.y == -5.0f) << "Resources were not injected.";
+    });
+
+    // Replacing a resource keeps a single instance
+    space.EmplaceResource<Clock>(1.0f);
+    ASSERT_TRUE(space.GetResource<Clock>().dt == 1.0f) << "Resource was not replaced.";
+    space.RemoveResource<Clock>();
+    ASSERT_FALSE(space.HasResource<Clock>()) << "Resource was not removed.";
+}
+
+TEST(Alloy, TagComponents)
+{
+    using namespace AlloyTesting::TagComponents;
+
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 100; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, static_cast<float>(i), 0.0f);
+        space.EmplaceComponent<Enemy>(entity);
+        if (i % 2 == 0)
+            space.InsertComponent<Stunned>(entity);
+        entities.emplace_back(entity);
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(space.HasComponent<Enemy>(entities[i])) << "Tag was not added.";
+        ASSERT_TRUE(space.GetComponentTemporary<PositionComponent>(entities[i]).x == static_cast<float>(i)) << "Tags corrupted component data.";
+    }
+
+    // Tags take no column
+    ASSERT_TRUE(X::Internal::ComponentTypeTraits::GetComponentInfo()[X::Internal::GetComponentId<Enemy>::value].size == 0) << "Empty component was not detected as a tag.";
+
+    int count = 0;
+    space.Update<PositionComponent, X::With<Stunned>>([&count](X::Entity, PositionComponent&) {
+        ++count;
+    });
+    ASSERT_TRUE(count == 50) << "Filter term did not select the tagged entities.";
+
+    count = 0;
+    space.Update<Enemy>([&count](X::Entity, Enemy&) {
+        ++count;
+    });
+    ASSERT_TRUE(count == 100) << "Requested tags should still be passed.";
+
+    for (int i = 0; i < 100; i += 2)
+        space.RemoveComponent<Stunned>(entities[i]);
+    count = 0;
+    space.Update<X::With<Stunned>>([&count](X::Entity) {
+        ++count;
+    });
+    ASSERT_TRUE(count == 0) << "Tag was not removed.";
+}
+
+TEST(Alloy, SparseComponents)
+{
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 100; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, static_cast<float>(i), 0.0f);
+        entities.emplace_back(entity);
+    }
+
+    for (int i = 0; i < 100; i += 10)
+        space.EmplaceComponent<SparseHit>(entities[i], i);
+    ASSERT_TRUE(space.HasComponent<SparseHit>(entities[10])) << "Sparse component was not added.";
+    ASSERT_FALSE(space.HasComponent<SparseHit>(entities[11])) << "Sparse component was added to the wrong entity.";
+    ASSERT_TRUE(space.GetComponentTemporary<SparseHit>(entities[20]).damage == 20) << "Sparse component data is incorrect.";
+
+    // Joined from the (smaller) sparse set
+    int count = 0;
+    space.Update<PositionComponent, SparseHit>([&count](X::Entity, PositionComponent& position, SparseHit& hit) {
+        ASSERT_TRUE(static_cast<int>(position.x) == hit.damage) << "Join paired the wrong components.";
+        ++count;
+    });
+    ASSERT_TRUE(count == 10) << "Sparse join count not met.";
+
+    // Joined from the archetypes
+    for (int i = 0; i < 100; ++i)
+        if (i % 10 != 0)
+            space.EmplaceComponent<SparseHit>(entities[i], i);
+    space.EmplaceComponent<SparseHit>(space.CreateEntity(), -1);
+    count = 0;
+    space.Update<PositionComponent, X::With<SparseHit>>([&count](X::Entity, PositionComponent&) {
+        ++count;
+    });
+    ASSERT_TRUE(count == 100) << "Sparse filter count not met.";
+
+    for (int i = 0; i < 100; i += 2)
+        space.RemoveComponent<SparseHit>(entities[i]);
+    space.DestroyEntity(entities[1]);
+    count = 0;
+    space.Update<SparseHit>([&count](X::Entity, SparseHit&) {
+        ++count;
+    });
+    ASSERT_TRUE(count == 50) << "Sparse components were not removed.";
+}
+
+TEST(Alloy, SharedComponents)
+{
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 100; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, static_cast<float>(i), 0.0f);
+        space.EmplaceComponent<SharedTeam>(entity, i % 3);
+        entities.emplace_back(entity);
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(space.HasComponent<SharedTeam>(entities[i])) << "Shared component was not added.";
+        ASSERT_TRUE(space.GetComponentTemporary<SharedTeam>(entities[i]).team == i % 3) << "Shared component value is incorrect.";
+        ASSERT_TRUE(space.GetComponentTemporary<PositionComponent>(entities[i]).x == static_cast<float>(i)) << "Component data was lost.";
+    }
+
+    // One archetype per value, each visited with its own value
+    std::vector<int> counts(3, 0);
+    space.Update<PositionComponent, SharedTeam>([&counts](X::Entity, PositionComponent& position, const SharedTeam& team) {
+        ASSERT_TRUE(static_cast<int>(position.x) % 3 == team.team) << "Entity was given the wrong shared value.";
+        ++counts[team.team];
+    });
+    ASSERT_TRUE(counts[0] == 34 && counts[1] == 33 && counts[2] == 33) << "Shared update count not met.";
+
+    // Wrappers hand out the shared value read-only too
+    X::ComponentWrapperGeneric generic{ space, entities[5] };
+    const SharedTeam& genericTeam = generic.GetComponent<SharedTeam>();
+    X::ComponentWrapper<SharedTeam> wrapper{ space, entities[5] };
+    static_assert(std::is_same_v<decltype(generic.GetComponent<SharedTeam>()), const SharedTeam&>, "Shared components must be read-only.");
+    static_assert(std::is_same_v<decltype(wrapper.GetComponent()), const SharedTeam&>, "Shared components must be read-only.");
+    ASSERT_TRUE(genericTeam.team == 2 && wrapper->team == 2) << "Wrapper returned the wrong shared value.";
+
+    // Adding another component keeps the value
+    space.EmplaceComponent<DirectionComponent>(entities[4], 1.0f, 1.0f);
+    ASSERT_TRUE(space.GetComponentTemporary<SharedTeam>(entities[4]).team == 1) << "Shared value was lost in a transfer.";
+
+    space.RemoveComponent<SharedTeam>(entities[4]);
+    ASSERT_FALSE(space.HasComponent<SharedTeam>(entities[4])) << "Shared component was not removed.";
+    space.EmplaceComponent<SharedTeam>(entities[4], 2);
+    ASSERT_TRUE(space.GetComponentTemporary<SharedTeam>(entities[4]).team == 2) << "Shared component value is incorrect.";
+}
+
+TEST(Alloy, LateQueryRegistration)
+{
+    using namespace AlloyTesting::LateQueryRegistration;
+
+    X::Space space{};
+    for (int i = 0; i < 30; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<LateA>(entity, i);
+        if (i % 2 == 0)
+            space.EmplaceComponent<LateB>(entity, i);
+        if (i % 3 == 0)
+            space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+    }
+
+    // Both queries are first instantiated here, after all of their archetypes exist
+    int bothCount = 0;
+    space.Update<LateB, LateA>([&bothCount](X::Entity, LateB& b, LateA& a) {
+        ASSERT_TRUE(a.value == b.value) << "Query matched the wrong archetype.";
+        ++bothCount;
+    });
+    ASSERT_TRUE(bothCount == 15) << "Late query missed archetypes.";
+
+    int positionCount = 0;
+    space.Update<LateA, PositionComponent>([&positionCount](X::Entity, LateA&, PositionComponent&) {
+        ++positionCount;
+    });
+    ASSERT_TRUE(positionCount == 10) << "Late query missed archetypes.";
+
+    // New archetypes are still picked up by existing queries
+    X::Entity entity = space.CreateEntity();
+    space.EmplaceComponent<LateB>(entity, 7);
+    space.EmplaceComponent<DirectionComponent>(entity, 0.0f, 0.0f);
+    space.EmplaceComponent<LateA>(entity, 7);
+    bothCount = 0;
+    space.Update<LateB, LateA>([&bothCount](X::Entity, LateB&, LateA&) {
+        ++bothCount;
+    });
+    ASSERT_TRUE(bothCount == 16) << "Query missed a new archetype.";
+}
+
+TEST(Alloy, Schedule)
+{
+    struct Sum
+    {
+        float value;
+    };
+
+    X::Space space{};
+    space.EmplaceResource<Sum>(0.0f);
+    for (int i = 0; i < 1000; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+        space.EmplaceComponent<DirectionComponent>(entity, 1.0f, static_cast<float>(i % 4));
+        if (i % 2 == 0)
+            space.EmplaceComponent<CFirst>(entity, CFirst{ 0, 0 });
+    }
+
+    X::Schedule schedule(3);
+    // Reads directions, writes positions
+    schedule.Add<PositionComponent, const DirectionComponent>([](X::Entity, PositionComponent& position, const DirectionComponent& direction) {
+        position.x += direction.x;
+        position.y += direction.y;
+    });
+    // Independent of every other system
+    schedule.Add<CFirst>([](X::Entity, CFirst& first) {
+        ++first.c;
+    });
+    // Must run after the first system has read the directions
+    schedule.Add<DirectionComponent>([](X::Entity, DirectionComponent& direction) {
+        direction.x *= 2.0f;
+    });
+    // Must run after the first system has written the positions
+    schedule.Add<const PositionComponent, X::Resource<Sum>>([](X::Entity, const PositionComponent& position, Sum& sum) {
+        sum.value += position.x;
+    });
+    ASSERT_TRUE(schedule.GetSystemCount() == 4) << "Systems were not added.";
+
+    for (int frame = 0; frame < 3; ++frame)
+        schedule.Run(space);
+
+    // Serially: x = 1 + 2 + 4, sums are 1000 * (1 + 3 + 7)
+    space.Update<PositionComponent, DirectionComponent>([](X::Entity, PositionComponent& position, DirectionComponent& direction) {
+        ASSERT_TRUE(position.x == 7.0f) << "Systems ran out of order.";
+        ASSERT_TRUE(direction.x == 8.0f) << "Systems ran out of order.";
+    });
+    space.Update<CFirst>([](X::Entity, CFirst& first) {
+        ASSERT_TRUE(first.c == 3) << "System did not run every frame.";
+    });
+    ASSERT_TRUE(space.GetResource<Sum>().value == 11000.0f) << "Systems ran out of order.";
+
+    // No workers runs everything on the calling thread
+    X::Schedule serial(0);
+    serial.Add<DirectionComponent>([](X::Entity, DirectionComponent& direction) {
+        direction.x = 0.0f;
+    });
+    serial.Run(space);
+    space.Update<DirectionComponent>([](X::Entity, DirectionComponent& direction) {
+        ASSERT_TRUE(direction.x == 0.0f) << "Serial schedule did not run.";
+    });
+}
+
+TEST(Alloy, ConstTerms)
+{
+    struct Scale
+    {
+        float value;
+    };
+
+    X::Space space{};
+    space.EmplaceResource<Scale>(2.0f);
+    for (int i = 0; i < 10; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+        space.EmplaceComponent<DirectionComponent>(entity, 1.0f, 2.0f);
+    }
+
+    space.Update<PositionComponent, const DirectionComponent, X::Resource<const Scale>>(
+        [](X::Entity, auto& position, auto& direction, auto& scale) {
+            static_assert(!std::is_const_v<std::remove_reference_t<decltype(position)>>, "Mutable terms must stay mutable.");
+            static_assert(std::is_const_v<std::remove_reference_t<decltype(direction)>>, "Const terms must be passed as const.");
+            static_assert(std::is_const_v<std::remove_reference_t<decltype(scale)>>, "Const resources must be passed as const.");
+            position.x += direction.x * scale.value;
+        });
+
+    // Const terms match the same archetypes as mutable ones
+    int count = 0;
+    space.Update<const PositionComponent>([&count](X::Entity, const PositionComponent& position) {
+        ASSERT_TRUE(position.x == 2.0f) << "Const update read incorrect data.";
+        ++count;
+    });
+    ASSERT_TRUE(count == 10) << "Const query matched the wrong archetypes.";
+}
+
+TEST(Alloy, DeducedEach)
+{
+    X::Space space{};
+    for (int i = 0; i < 20; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+        if (i % 2 == 0)
+            space.EmplaceComponent<DirectionComponent>(entity, 1.0f, 2.0f);
+    }
+
+    // Terms and constness come from the parameters, no entity is passed
+    int count = 0;
+    space.Each([&count](PositionComponent& position, const DirectionComponent& direction) {
+        position.x += direction.x;
+        position.y += direction.y;
+        ++count;
+    });
+    ASSERT_TRUE(count == 10) << "Deduced terms matched the wrong archetypes.";
+
+    // A leading entity is passed through
+    float sum = 0.0f;
+    space.Each([&space, &sum](X::Entity entity, const PositionComponent& position) mutable {
+        ASSERT_TRUE(space.HasComponent<PositionComponent>(entity)) << "Entity was not passed.";
+        sum += position.y;
+    });
+    ASSERT_TRUE(sum == 20.0f) << "Deduced update read incorrect data.";
+}
+
+#ifdef ALLOY_INSTRUMENTATION
+TEST(Alloy, Instrumentation)
+{
+    using namespace AlloyTesting::Instrumentation;
+
+    X::Instrumentation::Reset();
+    X::Instrumentation::SetTracing(true);
+
+    X::Space space{};
+    for (int i = 0; i < 10; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<InstrumentedA>(entity, i);
+        if (i < 4)
+            space.EmplaceComponent<InstrumentedB>(entity, i);
+    }
+    // Leave an empty archetype behind
+    X::Entity destroyed = space.CreateEntity();
+    space.EmplaceComponent<InstrumentedA>(destroyed, 0);
+    space.EmplaceComponent<CFirst>(destroyed, CFirst{ 0, 0 });
+    space.DestroyEntity(destroyed);
+
+    for (int i = 0; i < 3; ++i)
+        space.Update<InstrumentedA>([](X::Entity, InstrumentedA&) {});
+
+    X::Instrumentation::SetTracing(false);
+    bool found = false;
+    for (const X::UpdateStats& stats : X::Instrumentation::GetUpdateStats())
+    {
+        if (stats.query.find(typeid(InstrumentedA).name()) == std::string::npos)
+            continue;
+        found = true;
+        ASSERT_TRUE(stats.calls == 3) << "Update calls were not counted.";
+        ASSERT_TRUE(stats.rows == 30) << "Visited rows were not counted.";
+        ASSERT_TRUE(stats.archetypes == 9 && stats.emptyArchetypes == 3) << "Visited archetypes were not counted.";
+    }
+    ASSERT_TRUE(found) << "Update was not instrumented.";
+
+    std::ostringstream trace{};
+    X::Instrumentation::WriteChromeTrace(trace);
+    ASSERT_TRUE(trace.str().find("\"ph\":\"X\"") != std::string::npos) << "Trace events were not written.";
+}
+#endif
+
+TEST(Alloy, MemoryStats)
+{
+    X::Space space{};
+    for (int i = 0; i < 100; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+        if (i < 10)
+            space.EmplaceComponent<DirectionComponent>(entity, 0.0f, 0.0f);
+    }
+
+    const X::SpaceMemoryStats stats = space.GetMemoryStats();
+    size_t rows = 0;
+    size_t usedBytes = 0;
+    bool foundPositions = false;
+    for (const X::ArchetypeMemoryStats& archetype : stats.archetypes)
+    {
+        rows += archetype.rows;
+        usedBytes += archetype.usedBytes;
+        ASSERT_TRUE(archetype.capacity >= archetype.rows) << "Capacity is below the live rows.";
+        ASSERT_TRUE(archetype.reservedBytes >= archetype.usedBytes) << "Reserved bytes are below the used bytes.";
+        ASSERT_TRUE(archetype.edgeBytes > 0) << "Edge vectors were not counted.";
+        ASSERT_TRUE(archetype.columnTableBytes > 0) << "Column table was not counted.";
+        if (archetype.rows == 90)
+        {
+            foundPositions = true;
+            ASSERT_TRUE(archetype.columns.size() == 2) << "Columns were not reported.";
+            ASSERT_TRUE(archetype.usedBytes == 90 * (sizeof(X::Entity) + sizeof(PositionComponent))) << "Used bytes are incorrect.";
+            ASSERT_TRUE(archetype.entityMapBytes >= 100 * sizeof(size_t)) << "Entity map bytes are incorrect.";
+        }
+    }
+    ASSERT_TRUE(foundPositions) << "Archetype was not reported.";
+    ASSERT_TRUE(rows == 100) << "Rows were not reported.";
+    ASSERT_TRUE(stats.usedBytes == usedBytes) << "Used totals are incorrect.";
+    ASSERT_TRUE(stats.entityManager.archetypeLookupBytes >= 100 * sizeof(void*)) << "Entity manager tables were not counted.";
+    ASSERT_TRUE(stats.reservedBytes > stats.usedBytes) << "Reserved totals are incorrect.";
+}
+
+TEST(Alloy, ComponentWrapperCache)
+{
+    X::Space space{};
+    X::Entity first = space.CreateEntity();
+    space.EmplaceComponent<PositionComponent>(first, 0.0f, 0.0f);
+    X::Entity entity = space.CreateEntity();
+    space.EmplaceComponent<PositionComponent>(entity, 1.0f, 2.0f);
+
+    X::ComponentWrapper<PositionComponent> wrapper{ space, entity };
+    ASSERT_TRUE(wrapper->x == 1.0f) << "Wrapper returned the wrong component.";
+
+    // Updates and entity creation keep the cached address
+    const uint64_t version = space.GetStructuralVersion();
+    space.Update<PositionComponent>([](X::Entity, PositionComponent& position) {
+        position.x += 1.0f;
+    });
+    X::Entity created = space.CreateEntity();
+    ASSERT_TRUE(space.GetStructuralVersion() == version) << "Non-structural operations changed the version.";
+    ASSERT_TRUE(wrapper->x == 2.0f) << "Cached component is stale.";
+
+    // Pool growth reallocates the rows
+    for (int i = 0; i < 100; ++i)
+        space.EmplaceComponent<PositionComponent>(space.CreateEntity(), 5.0f, 5.0f);
+    ASSERT_TRUE(space.GetStructuralVersion() != version) << "Structural operations did not change the version.";
+    ASSERT_TRUE(wrapper->x == 2.0f && wrapper->y == 2.0f) << "Wrapper did not follow a reallocation.";
+
+    // Destroying the first entity moves the last row into its place
+    space.DestroyEntity(first);
+    ASSERT_TRUE(wrapper->x == 2.0f && wrapper.GetComponent().y == 2.0f) << "Wrapper did not follow a moved row.";
+
+    // Adding a component moves the entity to another archetype
+    space.EmplaceComponent<DirectionComponent>(entity, 3.0f, 3.0f);
+    ASSERT_TRUE(wrapper->x == 2.0f) << "Wrapper did not follow an archetype change.";
+
+    // Sorting permutes rows
+    space.EmplaceComponent<PositionComponent>(created, 9.0f, 9.0f);
+    space.EmplaceComponent<DirectionComponent>(created, 0.0f, 0.0f);
+    space.Sort<PositionComponent>([](const PositionComponent& lhs, const PositionComponent& rhs) {
+        return lhs.x > rhs.x;
+    });
+    ASSERT_TRUE(wrapper->x == 2.0f) << "Wrapper did not follow a sort.";
+
+    // Pointing a wrapper at another entity, or another component, drops the cache
+    wrapper.SetEntity(created);
+    ASSERT_TRUE(wrapper->x == 9.0f) << "Wrapper kept the previous entity's component.";
+    X::ComponentWrapper<DirectionComponent> directionWrapper{ wrapper };
+    ASSERT_TRUE(directionWrapper->x == 0.0f) << "Wrapper kept another component's cache.";
+}
+
+TEST(Alloy, Gather)
+{
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 300; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, static_cast<float>(i), 0.0f);
+        if (i % 3 == 0)
+            space.EmplaceComponent<DirectionComponent>(entity, 1.0f, 1.0f);
+        entities.emplace_back(entity);
+    }
+
+    // Shuffled across archetypes, with duplicates
+    std::vector<X::Entity> list{};
+    for (int i = 0; i < 300; ++i)
+        list.emplace_back(entities[(i * 7) % 300]);
+    list.emplace_back(entities[5]);
+
+    size_t calls = 0;
+    space.Gather<PositionComponent>(list, [&calls](X::Entity, PositionComponent& position) {
+        position.y += 1.0f;
+        ++calls;
+    });
+    ASSERT_TRUE(calls == list.size()) << "Every listed entity should be visited.";
+    for (int i = 0; i < 300; ++i)
+        ASSERT_TRUE(space.GetComponentTemporary<PositionComponent>(entities[i]).y == (i == 5 ? 2.0f : 1.0f)) << "Gathered components are incorrect.";
+
+    // Results are written back in list order
+    std::vector<float> results{};
+    space.Gather<PositionComponent>(list, results, [](X::Entity, const PositionComponent& position) {
+        return position.x;
+    });
+    ASSERT_TRUE(results.size() == list.size()) << "Results were not sized to the list.";
+    for (size_t i = 0; i < list.size(); ++i)
+        ASSERT_TRUE(results[i] == space.GetComponentTemporary<PositionComponent>(list[i]).x) << "Results are out of order.";
+
+    // Enough entities to take the prefetching path
+    while (entities.size() < X::Internal::GatherPrefetchMinimumEntities)
+        entities.emplace_back(space.CreateEntity());
+    list.clear();
+    for (int i = 0; i < 300; ++i)
+        if ((i * 7) % 300 % 3 == 0)
+            list.emplace_back(entities[(i * 7) % 300]);
+    space.Gather<PositionComponent, DirectionComponent>(list, results, [](X::Entity, const PositionComponent& position, const DirectionComponent& direction) {
+        return position.x + direction.x;
+    });
+    for (size_t i = 0; i < list.size(); ++i)
+        ASSERT_TRUE(results[i] == space.GetComponentTemporary<PositionComponent>(list[i]).x + space.GetComponentTemporary<DirectionComponent>(list[i]).x) << "Prefetched results are incorrect.";
+}
+
+#ifdef ALLOY_STATIC_COMPONENTS
+template<typename... Components>
+constexpr size_t GetListedComponentCount(X::ComponentList<Components...>)
+{
+    return sizeof...(Components);
+}
+
+// Listed components follow the entity in list order
+template<typename... Components>
+constexpr bool HasDenseComponentIds(X::ComponentList<Components...>)
+{
+    size_t expected = 1;
+    return ((X::Internal::GetComponentId<Components>::value == expected++) && ...);
+}
+
+TEST(Alloy, StaticComponentIds)
+{
+    using X::Internal::ComponentTypeTraits;
+    using X::Internal::GetComponentId;
+
+    // Checked at compile time, so IDs and column sizes are constants
+    static_assert(GetComponentId<X::Entity>::value == 0, "The entity must be component 0.");
+    static_assert(HasDenseComponentIds(X::StaticComponents::Type{}), "Component IDs must be dense and in list order.");
+    static_assert(ComponentTypeTraits::CurrentCount() == GetListedComponentCount(X::StaticComponents::Type{}) + 1, "Component count must cover exactly the list.");
+    static_assert(ComponentTypeTraits::GetComponentSize(GetComponentId<PositionComponent>::value) == sizeof(PositionComponent), "Column size is incorrect.");
+    static_assert(ComponentTypeTraits::GetComponentSize(GetComponentId<AlloyTesting::TagComponents::Enemy>::value) == 0, "Tags must not take a column.");
+
+    // Nothing registers at run time, the component info is built from the list
+    const std::vector<ComponentTypeTraits::ComponentInfo>& componentInfo = ComponentTypeTraits::GetComponentInfo();
+    ASSERT_TRUE(componentInfo.size() == ComponentTypeTraits::CurrentCount()) << "Component info does not match the list.";
+    for (size_t componentId = 0; componentId < componentInfo.size(); ++componentId)
+        ASSERT_TRUE(componentInfo[componentId].size == ComponentTypeTraits::GetComponentSize(componentId)) << "Component info size is incorrect.";
+}
+#endif
+
+TEST(Alloy, EdgeColumnMoves)
+{
+    X::Space space{};
+    // Both entities reach the same archetypes through edges added in a different order, so columns sit at different positions
+    X::Entity first = space.CreateEntity();
+    space.EmplaceComponent<CFirst>(first, CFirst{ 1, 2 });
+    space.EmplaceComponent<CSecond>(first, CSecond{ 3, 4 });
+    space.EmplaceComponent<CThird>(first, CThird{ 5, 6 });
+    X::Entity second = space.CreateEntity();
+    space.EmplaceComponent<CThird>(second, CThird{ 15, 16 });
+    space.EmplaceComponent<CSecond>(second, CSecond{ 13, 14 });
+    space.EmplaceComponent<CFirst>(second, CFirst{ 11, 12 });
+
+    const auto check = [&space](X::Entity entity, unsigned long offset, bool hasSecond) {
+        ASSERT_TRUE(space.GetComponentTemporary<CFirst>(entity).e == offset + 1 && space.GetComponentTemporary<CFirst>(entity).c == offset + 2) << "First component was not moved.";
+        if (hasSecond)
+        {
+            ASSERT_TRUE(space.GetComponentTemporary<CSecond>(entity).e == offset + 3 && space.GetComponentTemporary<CSecond>(entity).c == offset + 4) << "Second component was not moved.";
+        }
+        ASSERT_TRUE(space.GetComponentTemporary<CThird>(entity).a == offset + 5 && space.GetComponentTemporary<CThird>(entity).b == offset + 6) << "Third component was not moved.";
+    };
+    check(first, 0, true);
+    check(second, 10, true);
+
+    // Backward edges, then the same forward edges again
+    for (int i = 0; i < 2; ++i)
+    {
+        space.RemoveComponent<CSecond>(first);
+        space.RemoveComponent<CSecond>(second);
+        check(first, 0, false);
+        check(second, 10, false);
+        space.EmplaceComponent<CSecond>(first, CSecond{ 3, 4 });
+        space.EmplaceComponent<CSecond>(second, CSecond{ 13, 14 });
+        check(first, 0, true);
+        check(second, 10, true);
+    }
+}
+
+TEST(Alloy, Clear)
+{
+    X::Space space{};
+    std::shared_ptr<int> owner = std::make_shared<int>(0);
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 200; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, static_cast<float>(i), 0.0f);
+        if (i % 2 == 0)
+            space.EmplaceComponent<OwnerComponent>(entity, owner);
+        if (i % 10 == 0)
+            space.EmplaceComponent<SparseHit>(entity, i);
+        entities.emplace_back(entity);
+    }
+    space.SetParent(entities[1], entities[0]);
+    X::Entity destroyed = entities[3];
+    space.DestroyEntity(destroyed);
+
+    const size_t reservedBytes = space.GetMemoryStats().reservedBytes;
+    space.Clear();
+    ASSERT_TRUE(owner.use_count() == 1) << "Component destructors were not called.";
+    ASSERT_TRUE(space.GetMemoryStats().reservedBytes == reservedBytes) << "Cleared storage was not kept.";
+    for (const X::Entity entity : entities)
+        ASSERT_FALSE(space.IsValid(entity)) << "Cleared entity is still valid.";
+    size_t count = 0;
+    space.Update<X::With<PositionComponent>>([&count](X::Entity) {
+        ++count;
+    });
+    ASSERT_TRUE(count == 0) << "Cleared entities were still updated.";
+
+    // Recreated entities reuse the IDs with new generations, and start without relations or sparse components
+    X::Entity first = space.CreateEntity();
+    X::Entity second = space.CreateEntity();
+    ASSERT_TRUE(first.GetId() == entities[0].GetId() && first != entities[0]) << "Cleared ID was not reused with a new generation.";
+    ASSERT_FALSE(space.HasParent(second)) << "Hierarchy was not cleared.";
+    ASSERT_FALSE(space.HasComponent<SparseHit>(first)) << "Sparse components were not cleared.";
+    space.EmplaceComponent<PositionComponent>(first, 1.0f, 0.0f);
+    space.EmplaceComponent<PositionComponent>(second, 2.0f, 0.0f);
+    space.EmplaceComponent<OwnerComponent>(second, owner);
+    ASSERT_TRUE(space.GetComponentTemporary<PositionComponent>(second).x == 2.0f) << "Recreated entity data is incorrect.";
+    ASSERT_TRUE(space.GetMemoryStats().reservedBytes == reservedBytes) << "Recreated entities did not reuse the storage.";
+
+    // Destroying one by one gives the same result
+    space.DestroyAllEntities();
+    ASSERT_TRUE(owner.use_count() == 1) << "Component destructors were not called.";
+    ASSERT_FALSE(space.IsValid(first) || space.IsValid(second)) << "Destroyed entity is still valid.";
+}
+
+TEST(Alloy, Reset)
+{
+    X::Space space{};
+    std::shared_ptr<int> owner = std::make_shared<int>(0);
+    const auto fill = [&space, &owner]() {
+        for (int i = 0; i < 100; ++i)
+        {
+            X::Entity entity = space.CreateEntity();
+            space.EmplaceComponent<PositionComponent>(entity, 1.0f, 0.0f);
+            space.EmplaceComponent<OwnerComponent>(entity, owner);
+        }
+        return &space.EmplaceResource<OwnerComponent>(owner);
+    };
+    const auto count = [&space]() {
+        size_t count = 0;
+        space.Update<PositionComponent>([&count](X::Entity, PositionComponent&) {
+            ++count;
+        });
+        return count;
+    };
+
+    const OwnerComponent* resource = fill();
+    ASSERT_TRUE(count() == 100) << "Update count not met.";
+    const size_t reservedBytes = space.GetMemoryStats().reservedBytes;
+
+    space.Reset();
+    ASSERT_TRUE(owner.use_count() == 1) << "Components and resources were not destroyed.";
+    ASSERT_FALSE(space.HasResource<OwnerComponent>()) << "Resource was not removed.";
+    ASSERT_TRUE(count() == 0) << "Reset entities were still updated.";
+    ASSERT_TRUE(space.GetMemoryStats().reservedBytes == reservedBytes) << "Reset storage was not kept.";
+
+    // Refilled like before, the space reuses its archetypes, storage and resource memory
+    ASSERT_TRUE(fill() == resource) << "Resource memory was not reused.";
+    ASSERT_TRUE(count() == 100) << "Update count not met.";
+    ASSERT_TRUE(space.GetMemoryStats().reservedBytes == reservedBytes) << "Refilled space did not reuse its storage.";
+}
+
+#ifdef ALLOY_LATENCY_HISTOGRAMS
+TEST(Alloy, LatencyHistograms)
+{
+    using namespace AlloyTesting::LatencyHistograms;
+
+    ASSERT_TRUE(X::LatencyHistogram::GetBucketIndex(7) == 7) << "Small values must be exact.";
+    ASSERT_TRUE(X::LatencyHistogram::GetBucketLowerBound(X::LatencyHistogram::GetBucketIndex(1000)) <= 1000) << "Bucket bounds are incorrect.";
+    ASSERT_TRUE(X::LatencyHistogram::GetBucketLowerBound(X::LatencyHistogram::GetBucketIndex(1000) + 1) > 1000) << "Bucket bounds are incorrect.";
+
+    X::LatencyHistograms::Reset();
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 20; ++i)
+        entities.emplace_back(space.CreateEntity());
+    for (X::Entity entity : entities)
+        space.EmplaceComponent<LatencyA>(entity, 0);
+    space.RemoveComponent<LatencyA>(entities[0]);
+    space.DestroyEntity(entities[1]);
+
+    using X::ArchetypePath;
+    using X::StructuralOperation;
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::CreateEntity).GetCount() == 20) << "Creations were not recorded.";
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::DestroyEntity).GetCount() == 1) << "Destructions were not recorded.";
+    // The first add creates the archetype, every later one follows the cached edge
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::AddComponent, ArchetypePath::NewArchetype).GetCount() == 1) << "Add path was not recorded.";
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::AddComponent, ArchetypePath::EdgeHit).GetCount() == 19) << "Add path was not recorded.";
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::ArchetypeCreation).GetCount() == 1) << "Archetype creation was not recorded.";
+    // The base archetype already exists, so the backward lookup is found in the map
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::RemoveComponent, ArchetypePath::MapHit).GetCount() == 1) << "Remove path was not recorded.";
+    ASSERT_TRUE(X::LatencyHistograms::Get(StructuralOperation::PoolGrowth).GetCount() > 0) << "Pool growth was not recorded.";
+
+    const X::LatencyHistogram& adds = X::LatencyHistograms::Get(StructuralOperation::AddComponent, ArchetypePath::EdgeHit);
+    ASSERT_TRUE(adds.GetPercentile(50) <= adds.GetPercentile(99)) << "Percentiles are out of order.";
+}
+#endif
+
+#ifdef ALLOY_INSTRUMENTATION
+TEST(Alloy, TransitionStats)
+{
+    using namespace AlloyTesting::TransitionStats;
+
+    X::Space space{};
+    std::vector<X::Entity> entities{};
+    for (int i = 0; i < 10; ++i)
+    {
+        X::Entity entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+        entities.emplace_back(entity);
+    }
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        for (X::Entity entity : entities)
+            space.EmplaceComponent<ChurnA>(entity, frame);
+        for (X::Entity entity : entities)
+            space.RemoveComponent<ChurnA>(entity);
+    }
+
+    size_t addMoves = 0;
+    size_t removeMoves = 0;
+    for (const X::ArchetypeTransitionStats& transition : space.GetTransitionStats())
+    {
+        if (transition.componentId != X::Internal::GetComponentId<ChurnA>::value)
+            continue;
+        ASSERT_TRUE(transition.from != transition.to && transition.to != nullptr) << "Edge endpoints are incorrect.";
+        if (transition.added)
+        {
+            addMoves += transition.moves;
+            ASSERT_TRUE(transition.bytes == transition.moves * (sizeof(X::Entity) + sizeof(PositionComponent))) << "Copied bytes are incorrect.";
+        }
+        else
+        {
+            removeMoves += transition.moves;
+        }
+    }
+    ASSERT_TRUE(addMoves == 30 && removeMoves == 30) << "Transitions were not counted.";
+
+    std::ostringstream dot{};
+    space.WriteTransitionDot(dot);
+    ASSERT_TRUE(dot.str().find("30 moves") != std::string::npos) << "Transitions were not exported.";
+}
+#endif
+
+TEST(Alloy, RvalueUpdateArguments)
+{
+    using namespace AlloyTesting::RvalueUpdateArguments;
+
+    X::Space space{};
+    X::Entity root = space.CreateEntity();
+    X::Entity child = space.CreateEntity();
+    space.EmplaceComponent<Transform>(root, 1, 0);
+    space.EmplaceComponent<Transform>(child, 10, 0);
+    space.SetParent(child, root);
+
+    // Extra arguments taken as rvalue references are forwarded through every pool run
+    int sum = 0;
+    space.Update<Transform>([&sum](X::Entity, Transform& transform, int&& offset) {
+        sum += transform.local + offset;
+    }, 5);
+    ASSERT_TRUE(sum == 21) << "Rvalue argument was not passed to Update.";
+
+    space.UpdateHierarchy<Transform>([](X::Entity, Transform& transform, Transform* parent, int&& offset) {
+        transform.world = transform.local + offset + (parent ? parent->world : 0);
+    }, 5);
+    ASSERT_TRUE(space.GetComponentTemporary<Transform>(root).world == 6) << "Rvalue argument was not passed to the roots.";
+    ASSERT_TRUE(space.GetComponentTemporary<Transform>(child).world == 21) << "Rvalue argument was not passed to the children.";
+}
+
+#ifdef ALLOY_COUNT_ALLOCATIONS
+TEST(Alloy, ZeroAllocations)
+{
+    using namespace AlloyTesting::ZeroAllocations;
+
+    X::Space space{};
+    std::vector<X::Entity> entities(1000);
+    for (X::Entity& entity : entities)
+    {
+        entity = space.CreateEntity();
+        space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+        space.EmplaceComponent<DirectionComponent>(entity, 1.0f, 1.0f);
+    }
+
+    // Steady-state iteration, once the first update has created the query
+    const auto update = [&space]() {
+        space.Update<PositionComponent, const DirectionComponent>([](X::Entity, PositionComponent& position, const DirectionComponent& direction) {
+            position.x += direction.x;
+        });
+        space.Each([](PositionComponent& position, const DirectionComponent& direction) {
+            position.y += direction.y;
+        });
+    };
+    update();
+    {
+        AlloyTesting::AllocationCounter allocations{};
+        update();
+        ASSERT_TRUE(allocations.GetCount() == 0) << "Steady-state iteration allocated.";
+    }
+
+    // Warm edge transitions, once a round trip has created the edges and grown the pools
+    const auto addRemove = [&space, &entities]() {
+        for (X::Entity entity : entities)
+            space.EmplaceComponent<AllocationExtra>(entity, 1);
+        for (X::Entity entity : entities)
+            space.RemoveComponent<AllocationExtra>(entity);
+    };
+    addRemove();
+    {
+        AlloyTesting::AllocationCounter allocations{};
+        addRemove();
+        ASSERT_TRUE(allocations.GetCount() == 0) << "Warm edge transitions allocated.";
+    }
+
+    // Recycled ID creation, once a round of destruction has grown the free list and the base pool
+    // Debug builds track live IDs in a hash set, which allocates
+#ifndef ALLOY_DEBUG
+    const auto destroyCreate = [&space, &entities]() {
+        for (X::Entity entity : entities)
+            space.DestroyEntity(entity);
+        for (X::Entity& entity : entities)
+            entity = space.CreateEntity();
+    };
+    destroyCreate();
+    {
+        AlloyTesting::AllocationCounter allocations{};
+        destroyCreate();
+        ASSERT_TRUE(allocations.GetCount() == 0) << "Recycled ID creation allocated.";
+    }
+
+    // Refilling a reset space, once it has been filled before
+    const auto resetRefill = [&space, &entities, &update]() {
+        space.Reset();
+        space.EmplaceResource<AllocationExtra>(1);
+        for (X::Entity& entity : entities)
+        {
+            entity = space.CreateEntity();
+            space.EmplaceComponent<PositionComponent>(entity, 0.0f, 0.0f);
+            space.EmplaceComponent<DirectionComponent>(entity, 1.0f, 1.0f);
+        }
+        update();
+    };
+    resetRefill();
+    {
+        AlloyTesting::AllocationCounter allocations{};
+        resetRefill();
+        ASSERT_TRUE(allocations.GetCount() == 0) << "Refilling a reset space allocated.";
+    }
+#endif
+}
+#endif
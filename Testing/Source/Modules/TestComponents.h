@@ -0,0 +1,358 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+// Components used by the tests
+// Also the ALLOY_STATIC_COMPONENTS header of the AlloyTesting_StaticComponents configuration, so it is included by Alloy itself
+// Only the entity is defined at that point, so nothing here may use the rest of Alloy
+
+namespace X
+{
+class Space;
+} // namespace X
+
+struct CFirst
+{
+    long unsigned e;
+    long unsigned c;
+};
+
+struct CSecond
+{
+    long unsigned e;
+    long unsigned c;
+};
+
+struct CThird
+{
+    long unsigned a;
+    long unsigned b;
+};
+
+struct PositionComponent
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct DirectionComponent
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct ComflabulationComponent
+{
+    float thingy = 0.0;
+    long unsigned dingy = 0;
+    bool mingy = false;
+};
+
+struct SparseHit
+{
+    int damage;
+};
+
+template<>
+struct X::ComponentStorageType<SparseHit>
+{
+    static constexpr X::StorageType value = X::StorageType::Sparse;
+};
+
+struct SharedTeam
+{
+    int team;
+
+    bool operator==(const SharedTeam& other) const
+    {
+        return team == other.team;
+    }
+};
+
+template<>
+struct X::ComponentStorageType<SharedTeam>
+{
+    static constexpr X::StorageType value = X::StorageType::Shared;
+};
+
+struct OwnerComponent
+{
+    std::shared_ptr<int> owner;
+};
+
+// Components of a single test or benchmark, named after it
+namespace AlloyTesting
+{
+
+namespace EmplaceRemoveComponent
+{
+struct Component
+{
+    int var;
+};
+} // namespace EmplaceRemoveComponent
+
+namespace InsertRemoveComponent
+{
+struct Component
+{
+    int var;
+};
+} // namespace InsertRemoveComponent
+
+namespace Get1KComponent
+{
+struct Component
+{
+    int var;
+};
+} // namespace Get1KComponent
+
+namespace Get1KComponentTemporary
+{
+struct Component
+{
+    int var;
+};
+} // namespace Get1KComponentTemporary
+
+namespace UpdateOn1KEntities
+{
+struct Component
+{
+    int ivar;
+};
+} // namespace UpdateOn1KEntities
+
+namespace UpdateOn1KEntities2Components
+{
+struct Component
+{
+    int ivar;
+};
+
+struct Component2
+{
+    int ivar;
+};
+} // namespace UpdateOn1KEntities2Components
+
+namespace CreateDestroy100EntitiesInOrderWithOneComponent
+{
+struct Component
+{
+    int a;
+    int b;
+};
+} // namespace CreateDestroy100EntitiesInOrderWithOneComponent
+
+namespace CreateDestroy10EntitiesReverseOrderWithOneComponent
+{
+struct Component
+{
+    int a;
+    int b;
+};
+} // namespace CreateDestroy10EntitiesReverseOrderWithOneComponent
+
+namespace EmplaceIsValid
+{
+struct Component1
+{
+    int a{ 1 };
+};
+
+struct Component2
+{
+    // Defined with the test, once the space is
+    Component2(X::Space& space, X::Entity entity);
+    int b{ 2 };
+};
+} // namespace EmplaceIsValid
+
+namespace ComponentDataValidation
+{
+struct Component1
+{
+    std::string string{};
+    std::vector<int> vector{};
+
+    Component1() {}
+
+    //        int& a;
+
+    //        Component1(const Component1& other) : string(other.string), vector(other.vector), a(other.a)
+    //        {}
+    //
+    Component1(const std::string& string, const std::vector<int> vector, int& a) : string(string), vector(vector) /*, a(a)*/
+    {}
+
+    Component1(const Component1& other) = delete;
+    Component1& operator=(const Component1& other)
+    {
+        string = other.string;
+        vector = other.vector;
+        //            a = other.a;
+        return *this;
+    }
+};
+
+struct Component2
+{
+    int a;
+};
+} // namespace ComponentDataValidation
+
+namespace Random
+{
+struct DebugComponent
+{
+};
+} // namespace Random
+
+namespace Hierarchy
+{
+struct Transform
+{
+    int local;
+    int world;
+};
+
+struct Path
+{
+    std::string name;
+};
+} // namespace Hierarchy
+
+namespace SortByComponent
+{
+struct Key
+{
+    int value;
+};
+
+struct Name
+{
+    std::string name;
+};
+} // namespace SortByComponent
+
+namespace TagComponents
+{
+struct Enemy
+{
+};
+
+struct Stunned
+{
+};
+} // namespace TagComponents
+
+namespace LateQueryRegistration
+{
+struct LateA
+{
+    int value;
+};
+
+struct LateB
+{
+    int value;
+};
+} // namespace LateQueryRegistration
+
+namespace Instrumentation
+{
+struct InstrumentedA
+{
+    int value;
+};
+
+struct InstrumentedB
+{
+    int value;
+};
+} // namespace Instrumentation
+
+namespace LatencyHistograms
+{
+struct LatencyA
+{
+    int value;
+};
+} // namespace LatencyHistograms
+
+namespace TransitionStats
+{
+struct ChurnA
+{
+    int value;
+};
+} // namespace TransitionStats
+
+namespace RvalueUpdateArguments
+{
+struct Transform
+{
+    int local;
+    int world;
+};
+} // namespace RvalueUpdateArguments
+
+namespace ZeroAllocations
+{
+struct AllocationExtra
+{
+    int value;
+};
+} // namespace ZeroAllocations
+
+} // namespace AlloyTesting
+
+#ifdef ALLOY_STATIC_COMPONENTS
+
+// Resources are not listed, they are not components
+struct X::StaticComponents
+{
+    using Type = X::ComponentList<
+            CFirst,
+            CSecond,
+            CThird,
+            PositionComponent,
+            DirectionComponent,
+            ComflabulationComponent,
+            SparseHit,
+            SharedTeam,
+            OwnerComponent,
+            AlloyTesting::EmplaceRemoveComponent::Component,
+            AlloyTesting::InsertRemoveComponent::Component,
+            AlloyTesting::Get1KComponent::Component,
+            AlloyTesting::Get1KComponentTemporary::Component,
+            AlloyTesting::UpdateOn1KEntities::Component,
+            AlloyTesting::UpdateOn1KEntities2Components::Component,
+            AlloyTesting::UpdateOn1KEntities2Components::Component2,
+            AlloyTesting::CreateDestroy100EntitiesInOrderWithOneComponent::Component,
+            AlloyTesting::CreateDestroy10EntitiesReverseOrderWithOneComponent::Component,
+            AlloyTesting::EmplaceIsValid::Component1,
+            AlloyTesting::EmplaceIsValid::Component2,
+            AlloyTesting::ComponentDataValidation::Component1,
+            AlloyTesting::ComponentDataValidation::Component2,
+            AlloyTesting::Random::DebugComponent,
+            AlloyTesting::Hierarchy::Transform,
+            AlloyTesting::Hierarchy::Path,
+            AlloyTesting::SortByComponent::Key,
+            AlloyTesting::SortByComponent::Name,
+            AlloyTesting::TagComponents::Enemy,
+            AlloyTesting::TagComponents::Stunned,
+            AlloyTesting::LateQueryRegistration::LateA,
+            AlloyTesting::LateQueryRegistration::LateB,
+            AlloyTesting::Instrumentation::InstrumentedA,
+            AlloyTesting::Instrumentation::InstrumentedB,
+            AlloyTesting::LatencyHistograms::LatencyA,
+            AlloyTesting::TransitionStats::ChurnA,
+            AlloyTesting::RvalueUpdateArguments::Transform,
+            AlloyTesting::ZeroAllocations::AllocationExtra>;
+};
+
+#endif